@@ -0,0 +1,389 @@
+// Measures dawnxr on the mock runtime, see mockruntime/dawnxr_mockruntime.cpp.
+//
+// Reports session bring-up time and time to first swapchain for a first and a recreated session, swapchain
+// create/destroy latency with and without pooling, per-call overhead from getCallStats and frame loop throughput. Uses
+// the mock runtime built with it unless XR_RUNTIME_JSON is already set, eg: to compare with a real runtime, and runs
+// unthrottled unless DAWNXR_MOCK_DISPLAY_RATE is set.
+//
+// Usage: dawnxr_bench [frameCount]
+
+#include <dawnxr.h>
+
+#include <dawn/dawn_proc.h>
+#include <dawn/native/DawnNative.h>
+
+#include <openxr/openxr.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+#define BENCH_TRY(EXPR)                                                                                                        \
+	do {                                                                                                                       \
+		auto r_ = (EXPR);                                                                                                      \
+		if (XR_FAILED(r_)) {                                                                                                   \
+			std::fprintf(stderr, "%s failed: %d (%s:%d)\n", #EXPR, (int)r_, __FILE__, __LINE__);                               \
+			std::exit(1);                                                                                                      \
+		}                                                                                                                      \
+	} while (0)
+
+constexpr XrDuration pollTimeout = 5000000000; // 5s
+
+double elapsedUs(Clock::time_point start) {
+	return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+void setDefaultEnv(const char* name, const char* value) {
+	if (std::getenv(name)) return;
+#ifdef _WIN32
+	_putenv_s(name, value);
+#else
+	setenv(name, value, 0);
+#endif
+}
+
+// Prints mean/min/median/max of a set of samples in microseconds.
+void printSamples(const char* name, std::vector<double> samples) {
+	std::sort(samples.begin(), samples.end());
+	double total = 0;
+	for (auto sample : samples) total += sample;
+	std::printf("  %-34s mean %9.1fus  min %9.1fus  median %9.1fus  max %9.1fus  (n=%zu)\n", name,
+				total / samples.size(), samples.front(), samples[samples.size() / 2], samples.back(), samples.size());
+}
+
+struct Bench {
+	dawn::native::Instance dawnInstance;
+	XrInstance instance = XR_NULL_HANDLE;
+	XrSystemId systemId = XR_NULL_SYSTEM_ID;
+	wgpu::Device device;
+	XrSession session = XR_NULL_HANDLE;
+	XrSpace space = XR_NULL_HANDLE;
+	int64_t colorFormat = 0;
+	XrViewConfigurationView configViews[2]{{XR_TYPE_VIEW_CONFIGURATION_VIEW}, {XR_TYPE_VIEW_CONFIGURATION_VIEW}};
+};
+
+// Polls events until the session reaches a state, the mock runtime queues state changes immediately.
+void waitSessionState(Bench& bench, XrSessionState state) {
+
+	auto deadline = Clock::now() + std::chrono::nanoseconds(pollTimeout);
+
+	for (;;) {
+		XrEventDataBuffer event{XR_TYPE_EVENT_DATA_BUFFER};
+		auto r = xrPollEvent(bench.instance, &event);
+		BENCH_TRY(r);
+		if (r == XR_SUCCESS && event.type == XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED &&
+			((XrEventDataSessionStateChanged&)event).state == state) {
+			return;
+		}
+		if (r == XR_EVENT_UNAVAILABLE && Clock::now() > deadline) {
+			std::fprintf(stderr, "Timed out waiting for session state %d\n", (int)state);
+			std::exit(1);
+		}
+	}
+}
+
+void createInstance(Bench& bench) {
+
+	const char* extensions[] = {XR_KHR_VULKAN_ENABLE2_EXTENSION_NAME};
+
+	XrInstanceCreateInfo createInfo{XR_TYPE_INSTANCE_CREATE_INFO};
+	std::snprintf(createInfo.applicationInfo.applicationName, XR_MAX_APPLICATION_NAME_SIZE, "dawnxr_bench");
+	createInfo.applicationInfo.apiVersion = XR_MAKE_VERSION(1, 0, XR_VERSION_PATCH(XR_CURRENT_API_VERSION));
+	createInfo.enabledExtensionCount = 1;
+	createInfo.enabledExtensionNames = extensions;
+	BENCH_TRY(xrCreateInstance(&createInfo, &bench.instance));
+
+	XrInstanceProperties props{XR_TYPE_INSTANCE_PROPERTIES};
+	BENCH_TRY(xrGetInstanceProperties(bench.instance, &props));
+	std::printf("Runtime: %s\n", props.runtimeName);
+
+	XrSystemGetInfo systemInfo{XR_TYPE_SYSTEM_GET_INFO};
+	systemInfo.formFactor = XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY;
+	BENCH_TRY(xrGetSystem(bench.instance, &systemInfo, &bench.systemId));
+
+	uint32_t n;
+	BENCH_TRY(xrEnumerateViewConfigurationViews(bench.instance, bench.systemId,
+												XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO, 2, &n, bench.configViews));
+}
+
+// A stereo color swapchain at the recommended view size, one array layer per eye.
+XrSwapchainCreateInfo getSwapchainCreateInfo(const Bench& bench) {
+
+	XrSwapchainCreateInfo createInfo{XR_TYPE_SWAPCHAIN_CREATE_INFO};
+	createInfo.usageFlags = XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+	createInfo.format = bench.colorFormat;
+	createInfo.sampleCount = 1;
+	createInfo.width = bench.configViews[0].recommendedImageRectWidth;
+	createInfo.height = bench.configViews[0].recommendedImageRectHeight;
+	createInfo.faceCount = 1;
+	createInfo.arraySize = 2;
+	createInfo.mipCount = 1;
+	return createInfo;
+}
+
+// Times each step from graphics requirements to a running session and its first swapchain. A recreated session reuses
+// the device and dawnxr's cached requirements and adapter options, so should skip most of the first session's cost.
+void bringUpSession(Bench& bench, const char* label) {
+
+	std::printf("Session bring-up, %s:\n", label);
+	auto total = Clock::now();
+
+	auto start = Clock::now();
+	dawnxr::GraphicsRequirementsDawn requirements{};
+	BENCH_TRY(
+		dawnxr::getGraphicsRequirements(bench.instance, bench.systemId, wgpu::BackendType::Vulkan, &requirements));
+	std::printf("  %-34s %9.1fus\n", "getGraphicsRequirements", elapsedUs(start));
+
+	start = Clock::now();
+	wgpu::ChainedStruct* xrOpts = nullptr;
+	BENCH_TRY(dawnxr::createRequestAdapterOptions(bench.instance, bench.systemId, wgpu::BackendType::Vulkan, &xrOpts));
+	std::printf("  %-34s %9.1fus\n", "createRequestAdapterOptions", elapsedUs(start));
+
+	if (!bench.device) {
+		start = Clock::now();
+		wgpu::RequestAdapterOptions adapterOpts{};
+		adapterOpts.backendType = wgpu::BackendType::Vulkan;
+		adapterOpts.nextInChain = xrOpts;
+		auto adapters = bench.dawnInstance.EnumerateAdapters(&adapterOpts);
+		if (adapters.empty()) {
+			std::fprintf(stderr, "No Vulkan adapter, is a software Vulkan driver (eg: lavapipe) installed?\n");
+			std::exit(1);
+		}
+		bench.device = wgpu::Device::Acquire(adapters[0].CreateDevice());
+		std::printf("  %-34s %9.1fus\n", "adapter + device", elapsedUs(start));
+	}
+
+	start = Clock::now();
+	dawnxr::GraphicsBindingDawn binding{};
+	binding.device = bench.device;
+	XrSessionCreateInfo createInfo{XR_TYPE_SESSION_CREATE_INFO};
+	createInfo.next = &binding;
+	createInfo.systemId = bench.systemId;
+	BENCH_TRY(dawnxr::createSession(bench.instance, &createInfo, &bench.session));
+	std::printf("  %-34s %9.1fus\n", "createSession", elapsedUs(start));
+
+	start = Clock::now();
+	waitSessionState(bench, XR_SESSION_STATE_READY);
+	XrSessionBeginInfo beginInfo{XR_TYPE_SESSION_BEGIN_INFO};
+	beginInfo.primaryViewConfigurationType = XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO;
+	BENCH_TRY(dawnxr::beginSession(bench.session, &beginInfo));
+	std::printf("  %-34s %9.1fus\n", "wait ready + beginSession", elapsedUs(start));
+
+	XrReferenceSpaceCreateInfo spaceInfo{XR_TYPE_REFERENCE_SPACE_CREATE_INFO};
+	spaceInfo.referenceSpaceType = XR_REFERENCE_SPACE_TYPE_LOCAL;
+	spaceInfo.poseInReferenceSpace.orientation.w = 1;
+	BENCH_TRY(xrCreateReferenceSpace(bench.session, &spaceInfo, &bench.space));
+
+	// The runtime's preferred format, as an app would pick.
+	uint32_t n;
+	BENCH_TRY(dawnxr::enumerateSwapchainFormats(bench.session, 0, &n, nullptr));
+	std::vector<int64_t> formats(n);
+	BENCH_TRY(dawnxr::enumerateSwapchainFormats(bench.session, n, &n, formats.data()));
+	bench.colorFormat = formats.at(0);
+
+	std::printf("  %-34s %9.1fus\n", "total", elapsedUs(total));
+
+	start = Clock::now();
+	auto createInfo = getSwapchainCreateInfo(bench);
+	XrSwapchain swapchain;
+	BENCH_TRY(dawnxr::createSwapchain(bench.session, &createInfo, &swapchain));
+	std::printf("  %-34s %9.1fus\n", "first createSwapchain", elapsedUs(start));
+	std::printf("  %-34s %9.1fus\n", "time to first swapchain", elapsedUs(total));
+	BENCH_TRY(dawnxr::destroySwapchain(swapchain));
+}
+
+void endSession(Bench& bench) {
+
+	BENCH_TRY(xrDestroySpace(bench.space));
+	BENCH_TRY(xrRequestExitSession(bench.session));
+	waitSessionState(bench, XR_SESSION_STATE_STOPPING);
+	BENCH_TRY(dawnxr::endSession(bench.session));
+	BENCH_TRY(dawnxr::destroySession(bench.session));
+	bench.session = XR_NULL_HANDLE;
+}
+
+void benchSwapchainLatency(Bench& bench, uint32_t poolSize, uint32_t iterations) {
+
+	BENCH_TRY(dawnxr::setSwapchainPoolSize(bench.session, poolSize));
+
+	auto createInfo = getSwapchainCreateInfo(bench);
+	std::vector<double> createTimes;
+	std::vector<double> destroyTimes;
+
+	// The first iteration warms up dawn's caches and the pool, so isn't counted.
+	for (auto i = 0u; i <= iterations; ++i) {
+		XrSwapchain swapchain;
+		auto start = Clock::now();
+		BENCH_TRY(dawnxr::createSwapchain(bench.session, &createInfo, &swapchain));
+		auto createTime = elapsedUs(start);
+
+		start = Clock::now();
+		BENCH_TRY(dawnxr::destroySwapchain(swapchain));
+		auto destroyTime = elapsedUs(start);
+
+		if (!i) continue;
+		createTimes.push_back(createTime);
+		destroyTimes.push_back(destroyTime);
+	}
+
+	std::printf("Swapchain latency, pool size %u:\n", poolSize);
+	printSamples("createSwapchain", createTimes);
+	printSamples("destroySwapchain", destroyTimes);
+
+	BENCH_TRY(dawnxr::setSwapchainPoolSize(bench.session, 0));
+}
+
+// One frame of the usual loop, clearing both eyes and submitting them in a projection layer.
+void runFrame(Bench& bench, XrSwapchain swapchain, const XrSwapchainCreateInfo& createInfo) {
+
+	XrFrameWaitInfo waitInfo{XR_TYPE_FRAME_WAIT_INFO};
+	XrFrameState frameState{XR_TYPE_FRAME_STATE};
+	BENCH_TRY(dawnxr::waitFrame(bench.session, &waitInfo, &frameState));
+
+	XrFrameBeginInfo beginInfo{XR_TYPE_FRAME_BEGIN_INFO};
+	BENCH_TRY(dawnxr::beginFrame(bench.session, &beginInfo));
+
+	XrSwapchainImageAcquireInfo acquireInfo{XR_TYPE_SWAPCHAIN_IMAGE_ACQUIRE_INFO};
+	uint32_t index;
+	const dawnxr::SwapchainImageViewsDawn* image;
+	BENCH_TRY(dawnxr::acquireSwapchainImage(swapchain, &acquireInfo, &index, &image));
+
+	XrSwapchainImageWaitInfo imageWaitInfo{XR_TYPE_SWAPCHAIN_IMAGE_WAIT_INFO};
+	imageWaitInfo.timeout = XR_INFINITE_DURATION;
+	BENCH_TRY(dawnxr::waitSwapchainImage(swapchain, &imageWaitInfo));
+
+	auto encoder = bench.device.CreateCommandEncoder();
+	for (auto& layerView : image->layerViews) {
+		wgpu::RenderPassColorAttachment colorAttachment{};
+		colorAttachment.view = layerView;
+		colorAttachment.loadOp = wgpu::LoadOp::Clear;
+		colorAttachment.storeOp = wgpu::StoreOp::Store;
+		colorAttachment.clearValue = {0.2, 0.3, 0.4, 1.0};
+
+		wgpu::RenderPassDescriptor passDesc{};
+		passDesc.colorAttachmentCount = 1;
+		passDesc.colorAttachments = &colorAttachment;
+		encoder.BeginRenderPass(&passDesc).End();
+	}
+	auto commands = encoder.Finish();
+	bench.device.GetQueue().Submit(1, &commands);
+
+	XrSwapchainImageReleaseInfo releaseInfo{XR_TYPE_SWAPCHAIN_IMAGE_RELEASE_INFO};
+	BENCH_TRY(dawnxr::releaseSwapchainImage(swapchain, &releaseInfo));
+
+	XrCompositionLayerProjectionView views[2]{};
+	for (auto eye = 0u; eye < 2; ++eye) {
+		views[eye].type = XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW;
+		views[eye].pose.orientation.w = 1;
+		views[eye].fov = {-0.8f, 0.8f, 0.8f, -0.8f};
+		views[eye].subImage.swapchain = swapchain;
+		views[eye].subImage.imageRect.extent = {(int32_t)createInfo.width, (int32_t)createInfo.height};
+		views[eye].subImage.imageArrayIndex = eye;
+	}
+
+	XrCompositionLayerProjection layer{XR_TYPE_COMPOSITION_LAYER_PROJECTION};
+	layer.space = bench.space;
+	layer.viewCount = 2;
+	layer.views = views;
+	const XrCompositionLayerBaseHeader* layers[] = {(const XrCompositionLayerBaseHeader*)&layer};
+
+	XrFrameEndInfo endInfo{XR_TYPE_FRAME_END_INFO};
+	endInfo.displayTime = frameState.predictedDisplayTime;
+	endInfo.environmentBlendMode = XR_ENVIRONMENT_BLEND_MODE_OPAQUE;
+	endInfo.layerCount = frameState.shouldRender ? 1 : 0;
+	endInfo.layers = layers;
+	BENCH_TRY(dawnxr::endFrame(bench.session, &endInfo));
+
+	bench.device.Tick();
+}
+
+void benchFrameLoop(Bench& bench, uint32_t frameCount) {
+
+	auto createInfo = getSwapchainCreateInfo(bench);
+	XrSwapchain swapchain;
+	BENCH_TRY(dawnxr::createSwapchain(bench.session, &createInfo, &swapchain));
+
+	// Warm up pipelines, the runtime's images etc.
+	for (auto i = 0u; i < 10; ++i) runFrame(bench, swapchain, createInfo);
+
+	uint64_t submitsBefore;
+	BENCH_TRY(dawnxr::getSessionSubmitCount(bench.session, &submitsBefore));
+
+	auto start = Clock::now();
+	for (auto i = 0u; i < frameCount; ++i) runFrame(bench, swapchain, createInfo);
+	auto elapsed = elapsedUs(start);
+
+	uint64_t submitsAfter;
+	BENCH_TRY(dawnxr::getSessionSubmitCount(bench.session, &submitsAfter));
+
+	std::printf("Frame loop, %u frames of %ux%u x2:\n", frameCount, createInfo.width, createInfo.height);
+	std::printf("  %-34s %9.1f fps  (%.1fus per frame)\n", "throughput", frameCount * 1e6 / elapsed,
+				elapsed / frameCount);
+	std::printf("  %-34s %9.2f\n", "dawnxr submits per frame", double(submitsAfter - submitsBefore) / frameCount);
+
+	// Again with timing on, for the per call overhead. Timing adds a little of its own, so isn't on for throughput.
+	BENCH_TRY(dawnxr::setTimingEnabled(true));
+	for (auto i = 0u; i < 10; ++i) runFrame(bench, swapchain, createInfo);
+	BENCH_TRY(dawnxr::resetCallStats());
+	BENCH_TRY(dawnxr::getSessionSubmitCount(bench.session, &submitsBefore));
+	for (auto i = 0u; i < frameCount; ++i) runFrame(bench, swapchain, createInfo);
+	BENCH_TRY(dawnxr::getSessionSubmitCount(bench.session, &submitsAfter));
+	BENCH_TRY(dawnxr::setTimingEnabled(false));
+
+	// Timed releases always submit, and waits also submit while the GPU keeps up, see getSessionSubmitCount.
+	std::printf("  %-34s %9.2f
+", "dawnxr submits per frame, timed", double(submitsAfter - submitsBefore) / frameCount);
+
+	uint32_t n;
+	BENCH_TRY(dawnxr::getCallStats(0, &n, nullptr));
+	std::vector<dawnxr::CallStatsDawn> stats(n);
+	BENCH_TRY(dawnxr::getCallStats(n, &n, stats.data()));
+	std::sort(stats.begin(), stats.end(), [](auto& a, auto& b) { return a.totalTime > b.totalTime; });
+
+	std::printf("Per call overhead, dawnxr time excluding the runtime:\n");
+	for (auto& stat : stats) {
+		if (!stat.callCount) continue;
+		std::printf("  %-34s mean %9.2fus  overhead %9.2fus  (n=%llu)\n", stat.name,
+					stat.totalTime / 1e3 / stat.callCount, (stat.totalTime - stat.runtimeTime) / 1e3 / stat.callCount,
+					(unsigned long long)stat.callCount);
+	}
+
+	BENCH_TRY(dawnxr::destroySwapchain(swapchain));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+
+#ifdef DAWNXR_MOCK_RUNTIME_JSON
+	setDefaultEnv("XR_RUNTIME_JSON", DAWNXR_MOCK_RUNTIME_JSON);
+#endif
+	setDefaultEnv("DAWNXR_MOCK_DISPLAY_RATE", "0");
+
+	uint32_t frameCount = argc > 1 ? (uint32_t)std::max(std::atoi(argv[1]), 1) : 500;
+
+	dawnProcSetProcs(&dawn::native::GetProcs());
+
+	Bench bench;
+	createInstance(bench);
+
+	bringUpSession(bench, "first session");
+	benchSwapchainLatency(bench, 0, 50);
+	benchSwapchainLatency(bench, 4, 50);
+	benchFrameLoop(bench, frameCount);
+	endSession(bench);
+
+	bringUpSession(bench, "recreated session");
+	endSession(bench);
+
+	bench.device = nullptr;
+	BENCH_TRY(dawnxr::destroyInstance(bench.instance));
+
+	return 0;
+}
@@ -0,0 +1,151 @@
+// Measures HandleMap::find contention, see src/dawnxr_handlemap.h.
+//
+// Runs 1-16 threads doing lookups of live handles, alone and with a writer thread creating and destroying handles, as
+// when swapchains are created on a loading thread. A std::mutex + std::unordered_map shows what the map replaces.
+// Reports total lookups per second and nanoseconds per lookup per thread. Doesn't need dawn or OpenXR.
+//
+// Usage: dawnxr_handlemap_bench [milliseconds per run]
+
+#include "dawnxr_handlemap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace dawnxr::internal;
+
+namespace {
+
+constexpr uint32_t handleCount = 64; // Live handles, about what a busy session has
+constexpr uint32_t threadCounts[] = {1, 2, 4, 8, 16};
+
+struct Object {
+	uint64_t id;
+};
+
+// Handles look like the pointers runtimes tend to return.
+uint64_t makeHandle(uint64_t i) {
+	return 0x10000000ull + i * 0x40;
+}
+
+struct LockedMap {
+	std::mutex mutex;
+	std::unordered_map<uint64_t, Object*> map;
+
+	Object* find(uint64_t handle) {
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = map.find(handle);
+		return it != map.end() ? it->second : nullptr;
+	}
+
+	bool insert(uint64_t handle, Object* object) {
+		std::lock_guard<std::mutex> lock(mutex);
+		return map.emplace(handle, object).second;
+	}
+
+	Object* erase(uint64_t handle) {
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = map.find(handle);
+		if (it == map.end()) return nullptr;
+		auto object = it->second;
+		map.erase(it);
+		return object;
+	}
+};
+
+// Runs readerCount lookup threads, plus a writer if withWriter, for duration. Returns total lookups.
+template <class Map> uint64_t run(Map& map, uint32_t readerCount, bool withWriter, std::chrono::milliseconds duration) {
+
+	std::vector<Object> objects(handleCount * 2);
+	for (auto i = 0u; i < objects.size(); ++i) objects[i].id = makeHandle(i);
+	for (auto i = 0u; i < handleCount; ++i) map.insert(makeHandle(i), &objects[i]);
+
+	std::atomic<bool> start{};
+	std::atomic<bool> stop{};
+	std::atomic<uint64_t> total{};
+	std::atomic<uint64_t> errors{};
+
+	std::vector<std::thread> threads;
+	for (auto t = 0u; t < readerCount; ++t) {
+		threads.emplace_back([&, t] {
+			while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+			uint64_t count = 0;
+			uint64_t bad = 0;
+			auto i = t * 7;
+			while (!stop.load(std::memory_order_relaxed)) {
+				// Batches so checking stop doesn't dominate.
+				for (auto n = 0; n < 256; ++n, ++i) {
+					auto handle = makeHandle(i % handleCount);
+					auto object = map.find(handle);
+					if (!object || object->id != handle) ++bad;
+				}
+				count += 256;
+			}
+			total += count;
+			errors += bad;
+		});
+	}
+
+	// Churns the second half of the objects, which readers never look up, so every find should still hit.
+	if (withWriter) {
+		threads.emplace_back([&] {
+			while (!start.load(std::memory_order_acquire)) std::this_thread::yield();
+			for (auto i = 0u; !stop.load(std::memory_order_relaxed); ++i) {
+				auto index = handleCount + i % handleCount;
+				map.insert(makeHandle(index), &objects[index]);
+				auto erased = map.erase(makeHandle(index));
+				if (erased != &objects[index]) ++errors;
+			}
+		});
+	}
+
+	start.store(true, std::memory_order_release);
+	std::this_thread::sleep_for(duration);
+	stop.store(true, std::memory_order_relaxed);
+	for (auto& thread : threads) thread.join();
+
+	for (auto i = 0u; i < handleCount; ++i) map.erase(makeHandle(i));
+
+	if (errors) {
+		std::fprintf(stderr, "%llu lookups returned the wrong object\n", (unsigned long long)errors.load());
+		std::exit(1);
+	}
+
+	return total;
+}
+
+template <class Map> void benchMap(const char* name, bool withWriter, std::chrono::milliseconds duration) {
+
+	std::printf("%s%s:\n", name, withWriter ? ", with a writer" : "");
+
+	for (auto threadCount : threadCounts) {
+		Map map;
+		auto lookups = run(map, threadCount, withWriter, duration);
+		auto seconds = std::chrono::duration<double>(duration).count();
+		std::printf("  %2u threads %10.1f Mlookups/s %8.1f ns/lookup/thread\n", threadCount, lookups / seconds / 1e6,
+					seconds * 1e9 * threadCount / lookups);
+	}
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+
+	auto duration = std::chrono::milliseconds(argc > 1 ? std::max(std::atoi(argv[1]), 1) : 500);
+
+	std::printf("%u hardware threads\n", std::thread::hardware_concurrency());
+
+	benchMap<HandleMap<uint64_t, Object>>("HandleMap", false, duration);
+	benchMap<HandleMap<uint64_t, Object>>("HandleMap", true, duration);
+	benchMap<LockedMap>("std::mutex + std::unordered_map", false, duration);
+	benchMap<LockedMap>("std::mutex + std::unordered_map", true, duration);
+
+	return 0;
+}
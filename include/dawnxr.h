@@ -2,6 +2,9 @@
 
 #include <dawn/webgpu_cpp.h>
 
+#include <functional>
+#include <vector>
+
 //#include <dawn/native/VulkanBackend.h>
 
 // Currently only supports windows platform and D3D12, Vulkan backends.
@@ -27,6 +30,10 @@
 #define XR_TYPE_SWAPCHAIN_IMAGE_DAWN_EXT XR_TYPE_SWAPCHAIN_IMAGE_D3D11_KHR
 #define XR_TYPE_GRAPHICS_REQUIREMENTS_DAWN_EXT XR_TYPE_GRAPHICS_REQUIREMENTS_D3D11_KHR
 
+// ...and the OpenGL ones for dawnxr specific structs
+#define XR_TYPE_HEADLESS_SESSION_CREATE_INFO_DAWN_EXT XR_TYPE_GRAPHICS_BINDING_OPENGL_WIN32_KHR
+#define XR_TYPE_SWAPCHAIN_MSAA_CREATE_INFO_DAWN_EXT XR_TYPE_SWAPCHAIN_IMAGE_OPENGL_KHR
+
 namespace dawnxr {
 
 // Mirrors the XrGraphicsBindingD3D12KHR etc structs.
@@ -43,25 +50,83 @@ struct SwapchainImageDawn {
 	wgpu::Texture texture;
 };
 
+// A swapchain image plus views of it that are created once when the swapchain is created, see acquireSwapchainImage.
+struct SwapchainImageViewsDawn {
+	wgpu::Texture texture;
+	wgpu::TextureView textureView;			   // View of the whole image, 2D array if the swapchain has array layers
+	std::vector<wgpu::TextureView> mipViews;   // Single mip level views, one per mip level
+	std::vector<wgpu::TextureView> layerViews; // Single layer 2D views of mip 0, one per array layer
+	wgpu::TextureView depthView;			   // Depth aspect view of the whole image for sampling, null for color formats
+
+	// Multisampled color target to render into with textureView/layerViews as the resolve target, using LoadOp::Clear
+	// and StoreOp::Discard, see SwapchainMsaaCreateInfoDawn. Null/empty for other swapchains. Multisampled textures
+	// can't have array layers, so layered swapchains only have msaaLayerViews, one single layer texture per layer.
+	wgpu::TextureView msaaTextureView;
+	std::vector<wgpu::TextureView> msaaLayerViews;
+};
+
 // Mirrors the XrGraphicsRequirementsD3D12KHR etc structs.
 struct GraphicsRequirementsDawn {
 	XrStructureType type = XR_TYPE_GRAPHICS_REQUIREMENTS_DAWN_EXT;
 	void* XR_MAY_ALIAS next = nullptr;
 };
 
-// Gets dawn graphics requirements for a given backend type. Currently just dumps backend requirements to stdout.
+// Chain to GraphicsBindingDawn::next to create a headless 'virtual HMD' session that doesn't need an OpenXR runtime or
+// headset. Swapchains are plain dawn textures and frame timing is simulated on a virtual display clock. Also used for
+// devices created with the Null backend. Only the dawnxr functions below can be used with headless sessions/swapchains.
+struct HeadlessSessionCreateInfoDawn {
+	XrStructureType type = XR_TYPE_HEADLESS_SESSION_CREATE_INFO_DAWN_EXT;
+	const void* XR_MAY_ALIAS next = nullptr;
+	XrDuration displayPeriod = 11111111; // 90Hz
+	XrBool32 throttle = XR_TRUE;		 // XR_FALSE to return from waitFrame immediately, eg: for throughput benchmarks.
+};
+
+// Chain to XrSwapchainCreateInfo::next, as the first struct in the chain, to also give a single sample color swapchain
+// a multisampled render target to render into and resolve to the swapchain image in the same pass, see
+// SwapchainImageViewsDawn::msaaTextureView. MSAA targets are shared by swapchains in the session with the same format
+// and size, and are transient attachments where the device supports them, so render passes using one must use
+// LoadOp::Clear and StoreOp::Discard, ie: the contents never outlive the pass. The swapchain needs a sampleCount and
+// mipCount of 1, XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT and a format WebGPU can multisample, ie: not RGBA32Float, and
+// RG11B10Ufloat only with the RG11B10UfloatRenderable feature, otherwise XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED.
+struct SwapchainMsaaCreateInfoDawn {
+	XrStructureType type = XR_TYPE_SWAPCHAIN_MSAA_CREATE_INFO_DAWN_EXT;
+	const void* XR_MAY_ALIAS next = nullptr;
+	uint32_t sampleCount = 4; // Only 4 is supported by WebGPU
+};
+
+// Gets dawn graphics requirements for a given backend type. Requirements are cached per instance and system, so only the
+// first call for a system goes to the runtime.
 XrResult getGraphicsRequirements(XrInstance instance, XrSystemId systemId, wgpu::BackendType backendType,
 								 GraphicsRequirementsDawn* graphicsRequirements);
 
-// Creates a dawn::native::AdapterDiscoveryOptionsBase subclass instance for a given backend type.
+// Creates a dawn::native::AdapterDiscoveryOptionsBase subclass instance for a given backend type. Options are cached per
+// instance and system, so repeated calls return the same options. They're owned by dawnxr and valid until destroyInstance.
 XrResult createRequestAdapterOptions(XrInstance instance, XrSystemId systemId, wgpu::BackendType backendType, wgpu::ChainedStruct** opts);
 
+// Use this instead of xrDestroyInstance. Releases state dawnxr caches per instance and system.
+XrResult destroyInstance(XrInstance instance);
+
 // Use this instead of xrCreateSession
 XrResult createSession(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session);
 
-// Use this instead of xrDestroySession
+// Use this instead of xrDestroySession. Also destroys any swapchains the session still has.
 XrResult destroySession(XrSession session);
 
+// Use this instead of xrBeginSession
+XrResult beginSession(XrSession session, const XrSessionBeginInfo* beginInfo);
+
+// Use this instead of xrEndSession
+XrResult endSession(XrSession session);
+
+// Use this instead of xrWaitFrame
+XrResult waitFrame(XrSession session, const XrFrameWaitInfo* waitInfo, XrFrameState* frameState);
+
+// Use this instead of xrBeginFrame
+XrResult beginFrame(XrSession session, const XrFrameBeginInfo* beginInfo);
+
+// Use this instead of xrEndFrame
+XrResult endFrame(XrSession session, const XrFrameEndInfo* endInfo);
+
 // Use this instead of xrEnumerateSwapchainFormats
 XrResult enumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInput, uint32_t* formatCountOutput,
 								   int64_t* formats);
@@ -69,11 +134,332 @@ XrResult enumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInp
 // Use this instead of xrCreateSwapChain
 XrResult createSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain);
 
+// Creates a swapchain on a worker thread so the calling thread doesn't stall while the runtime allocates images and dawn
+// wraps them. callback is called on the worker thread with the createSwapchain result once the swapchain is ready to
+// use, and calls complete in the order they were made. createInfo is copied, but anything on its next chain must stay
+// valid until the callback. The device must have the ImplicitDeviceSynchronization feature as it's used from both
+// threads. Calls still queued when the session is destroyed complete with XR_ERROR_HANDLE_INVALID, also on the worker
+// thread, so their callbacks may run after destroySession returns.
+XrResult createSwapchainAsync(XrSession session, const XrSwapchainCreateInfo* createInfo,
+							  std::function<void(XrResult, XrSwapchain)> callback);
+
 // Use this instead of xrDestroySwapChain
 XrResult destroySwapchain(XrSwapchain swapchain);
 
+// Keeps up to poolSize swapchains destroyed with destroySwapchain alive, so createSwapchain can hand them out again
+// instead of allocating and wrapping new runtime images, eg: when toggling between a few render resolutions. Only
+// swapchains created without a next chain are pooled, and never static image swapchains or swapchains destroyed with
+// images still acquired, as the runtime wouldn't let those images be acquired again. Pooled swapchains count towards
+// getSessionMemoryUsage. 0 (the default) disables pooling and destroys any pooled swapchains.
+XrResult setSwapchainPoolSize(XrSession session, uint32_t poolSize);
+
+// Enables generating mips 1..n from mip 0 on the GPU in releaseSwapchainImage, eg: for quad layers the compositor
+// minifies. Each mip is a bilinear downsample of the one above it. The swapchain needs a mipCount > 1, a color format
+// dawn can filter and render to, and XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT.
+XrResult setMipGenerationEnabled(XrSwapchain swapchain, bool enabled);
+
+// A swapchain image read back to CPU memory, see enableReadback.
+struct ReadbackFrameDawn {
+	uint64_t sequence;			// Index of the capture since readback was enabled, gaps are dropped captures
+	XrTime captureTime;			// Steady clock nanoseconds of the releaseSwapchainImage, as TimingEventDawn
+	uint32_t width;				// Of the dynamic resolution rect captured, divided by downscale
+	uint32_t height;
+	uint32_t bytesPerRow;		// Rows are padded to a multiple of 256 bytes
+	wgpu::TextureFormat format; // Same as the swapchain
+	const void* data;			// Only valid during the callback
+};
+
+// Readback settings, see enableReadback.
+struct ReadbackInfoDawn {
+	uint32_t bufferCount = 3; // Size of the buffer ring, ie: how many captures can be in flight
+	uint32_t downscale = 1;	  // Divides width and height with a bilinear blit before copying, to save bandwidth
+	uint32_t arrayLayer = 0;  // Which layer of a layered swapchain to capture
+	std::function<void(const ReadbackFrameDawn& frame)> callback;
+};
+
+// Readback counters, see getReadbackStats.
+struct ReadbackStatsDawn {
+	uint64_t capturedCount;	 // Copies submitted
+	uint64_t deliveredCount; // Copies passed to the callback
+	uint64_t droppedCount;	 // Releases skipped as every buffer was busy, plus failed maps
+};
+
+// Copies every released image of a swapchain into a ring of pre-allocated buffers and passes each one to the callback
+// once it's mapped, a few frames later. The callback runs from dawn's callback processing, ie: on whichever thread
+// ticks the device, and should copy the data out quickly to free the buffer. A release finding every buffer still busy
+// is dropped rather than stalling. With dynamic resolution only the getDynamicResolutionRect rendered that frame is
+// copied, so frame sizes vary. The swapchain needs XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT, or with downscale > 1,
+// XR_SWAPCHAIN_USAGE_SAMPLED_BIT and a format setMipGenerationEnabled supports. Pass nullptr to disable.
+XrResult enableReadback(XrSwapchain swapchain, const ReadbackInfoDawn* info);
+
+// Gets the readback counters of a swapchain.
+XrResult getReadbackStats(XrSwapchain swapchain, ReadbackStatsDawn* stats);
+
+// Upload settings, see enableUpload.
+struct UploadInfoDawn {
+	uint32_t bufferCount = 3; // Size of the staging buffer ring, ie: how many uploads can be written or in flight
+	uint32_t arrayLayer = 0;  // Which layer of a layered swapchain uploads go to
+};
+
+// A mapped staging buffer for one image, see beginUpload.
+struct UploadBufferDawn {
+	void* data; // height rows of bytesPerRow bytes in the swapchain's format, only valid until endUpload
+	uint32_t width;
+	uint32_t height;
+	uint32_t bytesPerRow; // Rows are padded to a multiple of 256 bytes
+	uint32_t slot;		  // Identifies the buffer to endUpload
+};
+
+// Upload counters, see getUploadStats.
+struct UploadStatsDawn {
+	uint64_t uploadedCount; // Buffers copied into a released image
+	uint64_t skippedCount;	// Buffers superseded by a newer one before a release could copy them
+	uint64_t stallCount;	// beginUpload calls that had to wait for a free buffer, including ones that timed out
+};
+
+// Enables uploading whole images from the CPU through a ring of mapped staging buffers, eg: for video frames or CPU
+// rendered UI on quad layers, including XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT swapchains. Producers write straight into a
+// buffer between beginUpload and endUpload from any thread, and releaseSwapchainImage copies the most recently ended
+// upload into mip 0 of the released image, in the same submit as its other work. Copied buffers are mapped again once
+// the GPU is done with them, which needs the device to be ticked. Swapchains with more than one image also keep a copy
+// of the last upload in a texture of their own, so images released before the next upload get it too. The swapchain
+// needs XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT and a color format. Pass nullptr to disable.
+XrResult enableUpload(XrSwapchain swapchain, const UploadInfoDawn* info);
+
+// Gets a free staging buffer to write an image into, waiting up to timeout nanoseconds for one. Returns
+// XR_TIMEOUT_EXPIRED if every buffer is still being written or copied, ie: the producer is ahead of the frame loop.
+XrResult beginUpload(XrSwapchain swapchain, XrDuration timeout, UploadBufferDawn* buffer);
+
+// Queues a buffer written since beginUpload for the next releaseSwapchainImage.
+XrResult endUpload(XrSwapchain swapchain, const UploadBufferDawn* buffer);
+
+// Gets the upload counters of a swapchain.
+XrResult getUploadStats(XrSwapchain swapchain, UploadStatsDawn* stats);
+
+// Mirror settings, see enableMirror.
+struct MirrorInfoDawn {
+	wgpu::Surface surface;	   // Eg: for a desktop window, configured by dawnxr
+	wgpu::TextureFormat format = wgpu::TextureFormat::BGRA8Unorm;
+	uint32_t width = 0;		   // Surface size, usually smaller than the swapchain
+	uint32_t height = 0;
+	// Mailbox or Immediate, falling back to the other if the surface doesn't support it. Never Fifo, as that can block
+	// the XR frame on desktop vsync.
+	wgpu::PresentMode presentMode = wgpu::PresentMode::Mailbox;
+	uint32_t arrayLayer = 0;   // Which layer of a layered swapchain to mirror, eg: the left eye
+	XrDuration period = 33333333; // Min time between mirror frames, 30Hz
+};
+
+// Mirror costs, see getMirrorStats.
+struct MirrorStatsDawn {
+	uint64_t frameCount;	 // Mirror frames presented
+	uint64_t failedCount;	 // Mirror frames skipped as the surface had no texture, eg: minimized window
+	XrDuration lastCpuTime;	 // CPU time of the last mirror frame, blit and present
+	XrDuration lastGpuTime;	 // GPU time of a recent mirror blit, 0 without the TimestampQuery feature
+	XrDuration totalCpuTime; // CPU time of all mirror frames
+};
+
+// Blits a layer of the swapchain's released images into a surface, at most once per period, so a desktop window can
+// show the headset view without re-rendering it. The blit happens in releaseSwapchainImage on the mirror's own
+// throttle, so most XR frames don't pay for it. With dynamic resolution only the getDynamicResolutionRect rendered that
+// frame is stretched over the surface. The swapchain needs XR_SWAPCHAIN_USAGE_SAMPLED_BIT and a format
+// setMipGenerationEnabled supports. Returns XR_ERROR_FEATURE_UNSUPPORTED if the surface supports neither Mailbox nor
+// Immediate. Pass nullptr to disable and unconfigure the surface.
+//
+// The mirror gets surface textures and presents on whatever thread calls releaseSwapchainImage, usually the XR frame
+// thread, so the surface must be usable from that thread and the app mustn't configure or present it itself while the
+// mirror is enabled.
+XrResult enableMirror(XrSwapchain swapchain, const MirrorInfoDawn* info);
+
+// Gets the mirror costs of a swapchain.
+XrResult getMirrorStats(XrSwapchain swapchain, MirrorStatsDawn* stats);
+
+// Dynamic resolution settings, see enableDynamicResolution.
+struct DynamicResolutionInfoDawn {
+	XrDuration targetGpuTime = 0; // GPU time budget for a frame's rendering to the swapchain
+	float minScale = 0.5f;		  // Smallest fraction of the swapchain width/height to render at
+	float maxScale = 1.0f;		  // Largest fraction of the swapchain width/height to render at, <= 1
+};
+
+// Enables dynamic resolution for a swapchain created at the max render size. Each frame, render into the sub-rect
+// returned by getDynamicResolutionRect and pass the same rect to XrSwapchainSubImage::imageRect. The rect is scaled to
+// keep the GPU time between waitSwapchainImage and releaseSwapchainImage near targetGpuTime, measured automatically
+// where the device has the TimestampQuery feature. Pass nullptr to disable.
+XrResult enableDynamicResolution(XrSwapchain swapchain, const DynamicResolutionInfoDawn* info);
+
+// Feeds a GPU frame time to the dynamic resolution controller, eg: on devices without TimestampQuery.
+XrResult updateDynamicResolution(XrSwapchain swapchain, XrDuration gpuTime);
+
+// Gets the sub-rect of the swapchain to render into for the current frame, or the whole swapchain if dynamic
+// resolution isn't enabled.
+XrResult getDynamicResolutionRect(XrSwapchain swapchain, XrRect2Di* imageRect);
+
+// Chains an XrCompositionLayerDepthInfoKHR for a depth swapchain to each projection view, so the compositor can use
+// depth for positional reprojection. Depth rects match the views' color rects, and a layered depth swapchain uses one
+// layer per view. depthInfos must have viewCount elements and outlive endFrame. nearZ/farZ are the projection's clip
+// planes, swap them for reversed-Z. Needs the XR_KHR_composition_layer_depth extension enabled on the instance.
+XrResult chainDepthInfos(XrSwapchain depthSwapchain, float nearZ, float farZ, uint32_t viewCount,
+						 XrCompositionLayerProjectionView* views, XrCompositionLayerDepthInfoKHR* depthInfos);
+
 // Use this instead of xrEnumerateSwapchainImages
 XrResult enumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityInput, uint32_t* imageCountOutput,
 								  XrSwapchainImageBaseHeader* images);
 
+// Gets the estimated bytes of GPU memory held by a swapchain's images, plus the staging buffers and textures of its
+// upload and readback while enabled, ignoring driver padding and compression.
+XrResult getSwapchainMemoryUsage(XrSwapchain swapchain, uint64_t* bytes);
+
+// Gets the total estimated bytes of a session's live and pooled swapchains, plus any MSAA targets, uploads and
+// readbacks. Pooled swapchains have theirs disabled.
+XrResult getSessionMemoryUsage(XrSession session, uint64_t* bytes);
+
+// Gets the number of queue submits dawnxr has made itself for a session. releaseSwapchainImage makes at most one, for a
+// pending upload, mip generation, readback, mirroring, restoring the image's attachment state and the GPU timer's
+// timestamps together, and none if none of those are enabled. While GPU timing is enabled (see setTimingEnabled and
+// enableDynamicResolution) that's every release, as it also writes the begin timestamp of the next image, and
+// waitSwapchainImage makes one more for a begin timestamp of its own unless the GPU is still busy with that release.
+XrResult getSessionSubmitCount(XrSession session, uint64_t* submitCount);
+
+// Use this instead of xrAcquireSwapchainImage
+XrResult acquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo, uint32_t* index);
+
+// As above, but also returns the acquired image and its cached views. The returned pointer is valid until the swapchain
+// is destroyed.
+XrResult acquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo, uint32_t* index,
+							   const SwapchainImageViewsDawn** image);
+
+// Use this instead of xrWaitSwapchainImage
+XrResult waitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo);
+
+// Use this instead of xrReleaseSwapchainImage
+XrResult releaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo);
+
+// Gets whether the GPU has finished the work submitted before an image's last releaseSwapchainImage, including the
+// app's own rendering to it, as of the device's last tick. Images that were never released are idle. Use this rather
+// than waiting for the whole queue, eg: before recycling a released image's resources.
+XrResult isSwapchainImageIdle(XrSwapchain swapchain, uint32_t index, XrBool32* idle);
+
+// Ticks the device until isSwapchainImageIdle, for up to timeout nanoseconds. Returns XR_TIMEOUT_EXPIRED if the image
+// is still busy. Ticks from the calling thread, so needs ImplicitDeviceSynchronization if other threads use the device.
+XrResult waitSwapchainImageIdle(XrSwapchain swapchain, uint32_t index, XrDuration timeout);
+
+// A timed span, either a wrapped dawnxr call on the CPU or swapchain image usage on the GPU.
+struct TimingEventDawn {
+	const char* name;	// Static string, the wrapper function name or "swapchainImage (GPU)"
+	uint32_t threadId;	// Small per-thread index, ~0u for GPU events
+	XrTime beginTime;	// Steady clock nanoseconds. GPU events start at the CPU time of waitSwapchainImage
+	XrTime endTime;
+};
+
+// Timing events recorded during a single frame. Frames end with endFrame.
+struct FrameTimingDawn {
+	static constexpr uint32_t maxEvents = 64;
+	uint64_t frameIndex;
+	uint32_t eventCount;
+	TimingEventDawn events[maxEvents];
+};
+
+// Enables recording of CPU timing events around every dawnxr call, plus GPU timing of swapchain image usage where
+// the device has the TimestampQuery feature. Disabled by default, and close to free while disabled.
+XrResult setTimingEnabled(bool enabled);
+
+// Polls frame timings completed since the last poll, oldest first. Timings are kept in a ring of recent frames, so
+// frames that aren't polled in time are dropped, as are events still being recorded, eg: GPU timings that haven't
+// resolved yet. Pass nullptr frames to get the number of frames available.
+XrResult pollFrameTimings(uint32_t frameCapacityInput, uint32_t* frameCountOutput, FrameTimingDawn* frames);
+
+// Polls all available frame timings and writes them to a Chrome trace JSON file, see chrome://tracing or Perfetto.
+XrResult writeChromeTrace(const char* path);
+
+// Totals for one wrapped dawnxr call while timing was enabled. runtimeTime is the part spent in the runtime (or the
+// headless session's virtual compositor), so totalTime - runtimeTime is the overhead dawnxr adds. Calls made by other
+// dawnxr calls, eg: destroySwapchain by destroySession, are counted under both.
+struct CallStatsDawn {
+	const char* name;
+	uint64_t callCount;
+	XrDuration totalTime;
+	XrDuration runtimeTime;
+};
+
+// Gets per call stats accumulated since timing was first enabled or the last resetCallStats, in no particular order.
+// Pass nullptr stats to get the number of calls with stats.
+XrResult getCallStats(uint32_t statsCapacityInput, uint32_t* statsCountOutput, CallStatsDawn* stats);
+
+// Zeroes all call stats, eg: after warming up.
+XrResult resetCallStats();
+
+// Opaque pipelined frame loop, see createFrameLoop.
+struct FrameLoop;
+
+// Creates a frame loop that runs waitFrame for a session on a dedicated thread, so the app can record frame N+1 while the
+// GPU is still busy with frame N. renderAheadDepth is the max number of submitted frames the GPU can be working on
+// before acquireFrame blocks. While blocked it sleeps until a frame completes, ticking the device about once a
+// millisecond so completions are seen even if no other thread ticks it. Swapchain images should still be released
+// before submitFrame as usual.
+XrResult createFrameLoop(XrSession session, uint32_t renderAheadDepth, FrameLoop** frameLoop);
+
+// Stops the wait thread and destroys a frame loop.
+XrResult destroyFrameLoop(FrameLoop* frameLoop);
+
+// Use this instead of waitFrame and beginFrame when using a frame loop.
+XrResult acquireFrame(FrameLoop* frameLoop, XrFrameState* frameState);
+
+// Use this instead of endFrame when using a frame loop, after submitting the frame's GPU work.
+XrResult submitFrame(FrameLoop* frameLoop, const XrFrameEndInfo* endInfo);
+
+// Opaque per-frame composition layer builder, see createFrameLayers.
+struct FrameLayers;
+
+// Creates a builder for the layers passed to endFrame. Layer structs live in an arena that's reset, not freed, each
+// frame, so once warmed up building and submitting layers doesn't allocate. Use one per thread that builds frames.
+XrResult createFrameLayers(FrameLayers** frameLayers);
+
+// Destroys a frame layer builder.
+XrResult destroyFrameLayers(FrameLayers* frameLayers);
+
+// Removes all layers, call before building each frame. Invalidates the previous getFrameEndInfo.
+XrResult resetFrameLayers(FrameLayers* frameLayers);
+
+// Adds a projection layer with one view per XrView, eg: from xrLocateViews. A subImage with an empty imageRect uses the
+// whole swapchain, or its getDynamicResolutionRect.
+XrResult addProjectionLayer(FrameLayers* frameLayers, XrSpace space, XrCompositionLayerFlags layerFlags,
+							uint32_t viewCount, const XrView* views, const XrSwapchainSubImage* subImages);
+
+// Adds depth to the last projection layer added, see chainDepthInfos.
+XrResult addProjectionDepth(FrameLayers* frameLayers, XrSwapchain depthSwapchain, float nearZ, float farZ);
+
+// Adds a quad layer visible to both eyes, eg: for UI. Empty imageRects are handled as with addProjectionLayer.
+XrResult addQuadLayer(FrameLayers* frameLayers, XrSpace space, XrCompositionLayerFlags layerFlags,
+					  const XrSwapchainSubImage* subImage, const XrPosef* pose, const XrExtent2Df* size);
+
+// Fills in an XrFrameEndInfo with the layers added since the last reset, in the order they were added.
+XrResult getFrameEndInfo(FrameLayers* frameLayers, XrTime displayTime, XrEnvironmentBlendMode blendMode,
+						 XrFrameEndInfo* endInfo);
+
+// Opaque on-disk cache of compiled shaders and pipelines, see createPipelineCache.
+struct PipelineCache;
+
+struct PipelineCacheStatsDawn {
+	uint64_t hitCount;	  // Blobs loaded from disk
+	uint64_t missCount;	  // Blobs dawn asked for that weren't cached, or were stale
+	uint64_t storeCount;  // Blobs written to disk
+	uint64_t loadedBytes;
+	uint64_t storedBytes;
+};
+
+// Creates a pipeline cache in a subdirectory of directory keyed by the adapter's vendor, device and driver, and by the
+// instance's runtime name and version, so a driver or runtime update starts a fresh cache instead of loading stale
+// blobs. Use chainPipelineCache to have devices created on adapter load and store compiled pipelines through it.
+XrResult createPipelineCache(XrInstance instance, const wgpu::Adapter& adapter, const char* directory,
+							 PipelineCache** pipelineCache);
+
+// Chains the cache's wgpu::DawnCacheDeviceDescriptor to a device descriptor, call just before CreateDevice. The cache
+// must outlive any devices created with it.
+XrResult chainPipelineCache(PipelineCache* pipelineCache, wgpu::DeviceDescriptor* deviceDesc);
+
+// Gets hit/miss/store counts since the cache was created.
+XrResult getPipelineCacheStats(PipelineCache* pipelineCache, PipelineCacheStatsDawn* stats);
+
+// Destroys a pipeline cache. Blobs already on disk are kept for the next launch.
+XrResult destroyPipelineCache(PipelineCache* pipelineCache);
+
 } // namespace dawnxr
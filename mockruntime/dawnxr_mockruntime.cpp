@@ -0,0 +1,1032 @@
+// Stand-in OpenXR runtime for measuring dawnxr without a headset or GPU, see bench/dawnxr_bench.cpp.
+//
+// Implements just enough of OpenXR 1.0 and XR_KHR_vulkan_enable2 for a dawn Vulkan session: Vulkan instance/device
+// creation goes through the app's vkGetInstanceProcAddr, preferring a CPU physical device (eg: lavapipe or
+// SwiftShader), swapchain images are plain VkImages on the app's device, and frames are timed on a virtual display
+// clock. Nothing is composited. Load it by pointing XR_RUNTIME_JSON at the dawnxr_mockruntime.json generated next to
+// the library. DAWNXR_MOCK_DISPLAY_RATE sets the display rate in Hz (default 90), 0 returns from xrWaitFrame
+// immediately, eg: for throughput benchmarks.
+
+#define XR_NO_PROTOTYPES 1
+#define VK_NO_PROTOTYPES 1
+#define XR_USE_GRAPHICS_API_VULKAN 1
+
+#include <vulkan/vulkan.h>
+
+#include <openxr/openxr.h>
+#include <openxr/openxr_loader_negotiation.h>
+#include <openxr/openxr_platform.h>
+#include <openxr/openxr_reflection.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#define DAWNXR_MOCK_EXPORT __declspec(dllexport)
+#else
+#define DAWNXR_MOCK_EXPORT __attribute__((visibility("default")))
+#endif
+
+// Entry points the runtime implements, everything else is XR_ERROR_FUNCTION_UNSUPPORTED.
+#define XR_MOCK_PROCS(X)                                                                                                       \
+	X(xrEnumerateInstanceExtensionProperties)                                                                                  \
+	X(xrCreateInstance)                                                                                                        \
+	X(xrDestroyInstance)                                                                                                       \
+	X(xrGetInstanceProperties)                                                                                                 \
+	X(xrPollEvent)                                                                                                             \
+	X(xrResultToString)                                                                                                        \
+	X(xrStructureTypeToString)                                                                                                 \
+	X(xrGetSystem)                                                                                                             \
+	X(xrGetSystemProperties)                                                                                                   \
+	X(xrEnumerateEnvironmentBlendModes)                                                                                        \
+	X(xrEnumerateViewConfigurations)                                                                                           \
+	X(xrGetViewConfigurationProperties)                                                                                        \
+	X(xrEnumerateViewConfigurationViews)                                                                                       \
+	X(xrCreateSession)                                                                                                         \
+	X(xrDestroySession)                                                                                                        \
+	X(xrBeginSession)                                                                                                          \
+	X(xrEndSession)                                                                                                            \
+	X(xrRequestExitSession)                                                                                                    \
+	X(xrCreateReferenceSpace)                                                                                                  \
+	X(xrDestroySpace)                                                                                                          \
+	X(xrLocateViews)                                                                                                           \
+	X(xrWaitFrame)                                                                                                             \
+	X(xrBeginFrame)                                                                                                            \
+	X(xrEndFrame)                                                                                                              \
+	X(xrEnumerateSwapchainFormats)                                                                                             \
+	X(xrCreateSwapchain)                                                                                                       \
+	X(xrDestroySwapchain)                                                                                                      \
+	X(xrEnumerateSwapchainImages)                                                                                              \
+	X(xrAcquireSwapchainImage)                                                                                                 \
+	X(xrWaitSwapchainImage)                                                                                                    \
+	X(xrReleaseSwapchainImage)                                                                                                 \
+	X(xrGetVulkanGraphicsRequirements2KHR)                                                                                     \
+	X(xrCreateVulkanInstanceKHR)                                                                                               \
+	X(xrGetVulkanGraphicsDevice2KHR)                                                                                           \
+	X(xrCreateVulkanDeviceKHR)
+
+// Vulkan entry points the runtime uses on the app's instance and device.
+#define VK_MOCK_INSTANCE_PROCS(X)                                                                                              \
+	X(vkGetDeviceProcAddr)                                                                                                     \
+	X(vkGetPhysicalDeviceMemoryProperties)
+
+#define VK_MOCK_DEVICE_PROCS(X)                                                                                                \
+	X(vkGetDeviceQueue)                                                                                                        \
+	X(vkDeviceWaitIdle)                                                                                                        \
+	X(vkCreateImage)                                                                                                           \
+	X(vkDestroyImage)                                                                                                          \
+	X(vkGetImageMemoryRequirements)                                                                                            \
+	X(vkAllocateMemory)                                                                                                        \
+	X(vkFreeMemory)                                                                                                            \
+	X(vkBindImageMemory)                                                                                                       \
+	X(vkCreateCommandPool)                                                                                                     \
+	X(vkDestroyCommandPool)                                                                                                    \
+	X(vkResetCommandPool)                                                                                                      \
+	X(vkAllocateCommandBuffers)                                                                                                \
+	X(vkBeginCommandBuffer)                                                                                                    \
+	X(vkEndCommandBuffer)                                                                                                      \
+	X(vkCmdPipelineBarrier)                                                                                                    \
+	X(vkQueueSubmit)                                                                                                           \
+	X(vkQueueWaitIdle)
+
+#define VK_MOCK_PROC(FUNCID) PFN_##FUNCID FUNCID{};
+
+namespace {
+
+constexpr XrSystemId systemId = 1;
+
+constexpr uint32_t viewWidth = 1440;
+constexpr uint32_t viewHeight = 1584;
+
+// In the order a typical runtime prefers them, sRGB first.
+constexpr int64_t swapchainFormats[] = {
+	VK_FORMAT_R8G8B8A8_SRGB, VK_FORMAT_B8G8R8A8_SRGB,	  VK_FORMAT_R8G8B8A8_UNORM, VK_FORMAT_B8G8R8A8_UNORM,
+	VK_FORMAT_R16G16B16A16_SFLOAT, VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM,
+};
+
+XrTime getTime() {
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+struct MockInstance {
+	XrDuration const displayPeriod; // 0 to not throttle xrWaitFrame
+
+	std::mutex mutex;
+	std::deque<XrEventDataBuffer> events;
+	bool requirementsQueried = false;
+
+	// From xrCreateVulkanInstanceKHR, the only way the app gives us its loader.
+	PFN_vkGetInstanceProcAddr getInstanceProcAddr = nullptr;
+	VkInstance vkInstance = VK_NULL_HANDLE;
+
+	explicit MockInstance(XrDuration displayPeriod) : displayPeriod(displayPeriod) {
+	}
+
+	template <class T> void pushEvent(const T& event) {
+		XrEventDataBuffer buffer{};
+		std::memcpy(&buffer, &event, sizeof(event));
+		std::lock_guard<std::mutex> lock(mutex);
+		events.push_back(buffer);
+	}
+};
+
+struct MockSwapchain;
+
+struct MockSession {
+	MockInstance* const instance;
+	XrGraphicsBindingVulkan2KHR const binding;
+
+	VK_MOCK_INSTANCE_PROCS(VK_MOCK_PROC)
+	VK_MOCK_DEVICE_PROCS(VK_MOCK_PROC)
+
+	VkQueue queue = VK_NULL_HANDLE;
+	VkCommandPool commandPool = VK_NULL_HANDLE;
+	VkPhysicalDeviceMemoryProperties memoryProps{};
+
+	std::mutex mutex; // Guards everything below
+	std::condition_variable frameBegun;
+	std::vector<MockSwapchain*> swapchains;
+	XrSessionState state = XR_SESSION_STATE_UNKNOWN;
+	bool running = false;
+	uint64_t waitedFrames = 0;
+	uint64_t begunFrames = 0;
+	bool frameInProgress = false;
+	XrTime lastVsyncTime = 0;
+
+	MockSession(MockInstance* instance, const XrGraphicsBindingVulkan2KHR& binding)
+		: instance(instance), binding(binding) {
+	}
+
+	void setState(XrSessionState newState) {
+		state = newState;
+		XrEventDataSessionStateChanged event{XR_TYPE_EVENT_DATA_SESSION_STATE_CHANGED};
+		event.session = (XrSession)this;
+		event.state = newState;
+		event.time = getTime();
+		instance->pushEvent(event);
+	}
+};
+
+struct MockSwapchain {
+	MockSession* const session;
+	XrSwapchainCreateInfo const createInfo;
+	std::vector<VkImage> images;
+	std::vector<VkDeviceMemory> memory;
+
+	// Only the app touches a swapchain and it's externally synchronized, so no locking.
+	std::deque<uint32_t> acquired; // Oldest first
+	uint32_t waitedCount = 0;	   // Acquired images that have been waited on, from the front
+	uint32_t nextImage = 0;
+	bool everAcquired = false;
+
+	MockSwapchain(MockSession* session, const XrSwapchainCreateInfo& createInfo)
+		: session(session), createInfo(createInfo) {
+	}
+
+	~MockSwapchain() {
+		for (auto image : images) session->vkDestroyImage(session->binding.device, image, nullptr);
+		for (auto mem : memory) session->vkFreeMemory(session->binding.device, mem, nullptr);
+	}
+};
+
+struct MockSpace {
+	MockSession* const session;
+};
+
+template <class T> T* fromHandle(void* handle) {
+	return (T*)handle;
+}
+
+template <class T> XrResult enumerate(const T* items, uint32_t count, uint32_t capacityInput, uint32_t* countOutput,
+									  T* output) {
+	if (!countOutput) return XR_ERROR_VALIDATION_FAILURE;
+	*countOutput = count;
+	if (!capacityInput) return XR_SUCCESS;
+	if (capacityInput < count) return XR_ERROR_SIZE_INSUFFICIENT;
+	std::copy(items, items + count, output);
+	return XR_SUCCESS;
+}
+
+bool isDepthFormat(int64_t format) {
+	return format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D16_UNORM;
+}
+
+// Real runtimes also sample and copy images in their compositors, and dawn copies into images to lazily clear them.
+VkImageUsageFlags getImageUsage(XrSwapchainUsageFlags usageFlags) {
+
+	VkImageUsageFlags usage =
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+
+	if (usageFlags & XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT) usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	if (usageFlags & XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+		usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+	}
+	if (usageFlags & XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT) usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+	if (usageFlags & XR_SWAPCHAIN_USAGE_INPUT_ATTACHMENT_BIT_KHR) usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+
+	return usage;
+}
+
+uint32_t findMemoryType(const VkPhysicalDeviceMemoryProperties& props, uint32_t typeBits) {
+	for (auto want : {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0}) {
+		for (auto i = 0u; i < props.memoryTypeCount; ++i) {
+			if ((typeBits & (1u << i)) && (props.memoryTypes[i].propertyFlags & want) == (VkMemoryPropertyFlags)want) {
+				return i;
+			}
+		}
+	}
+	return ~0u;
+}
+
+XrDuration getDisplayPeriod() {
+	auto rate = std::getenv("DAWNXR_MOCK_DISPLAY_RATE");
+	auto hz = rate ? std::atof(rate) : 90.0;
+	return hz > 0 ? (XrDuration)(1e9 / hz) : 0;
+}
+
+// Moves new images into the layout the runtime has to hand out at acquire. The queue belongs to the app, which dawn
+// only submits to from threads calling into it, and swapchains are created from those same threads.
+VkResult transitionImages(MockSession* session, const std::vector<VkImage>& images, const XrSwapchainCreateInfo& info) {
+
+	auto device = session->binding.device;
+
+	if (!session->commandPool) {
+		VkCommandPoolCreateInfo poolInfo{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = session->binding.queueFamilyIndex;
+		auto r = session->vkCreateCommandPool(device, &poolInfo, nullptr, &session->commandPool);
+		if (r != VK_SUCCESS) return r;
+	}
+
+	VkCommandBufferAllocateInfo allocInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+	allocInfo.commandPool = session->commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+	VkCommandBuffer commandBuffer;
+	auto r = session->vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer);
+	if (r != VK_SUCCESS) return r;
+
+	VkCommandBufferBeginInfo beginInfo{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	session->vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+	bool depth = isDepthFormat(info.format);
+
+	std::vector<VkImageMemoryBarrier> barriers;
+	for (auto image : images) {
+		VkImageMemoryBarrier barrier{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+		barrier.dstAccessMask =
+			depth ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout =
+			depth ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = {depth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT, 0, info.mipCount, 0,
+									info.arraySize};
+		barriers.push_back(barrier);
+	}
+	session->vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+								  VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr,
+								  (uint32_t)barriers.size(), barriers.data());
+
+	session->vkEndCommandBuffer(commandBuffer);
+
+	VkSubmitInfo submitInfo{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	r = session->vkQueueSubmit(session->queue, 1, &submitInfo, VK_NULL_HANDLE);
+	if (r == VK_SUCCESS) r = session->vkQueueWaitIdle(session->queue);
+
+	session->vkResetCommandPool(device, session->commandPool, 0);
+
+	return r;
+}
+
+namespace mock {
+
+// ***** Instance *****
+
+XrResult XRAPI_CALL xrEnumerateInstanceExtensionProperties(const char* layerName, uint32_t propertyCapacityInput,
+														   uint32_t* propertyCountOutput,
+														   XrExtensionProperties* properties) {
+
+	if (layerName) return XR_ERROR_API_LAYER_NOT_PRESENT;
+
+	XrExtensionProperties extensions[1]{{XR_TYPE_EXTENSION_PROPERTIES}};
+	std::strcpy(extensions[0].extensionName, XR_KHR_VULKAN_ENABLE2_EXTENSION_NAME);
+	extensions[0].extensionVersion = XR_KHR_vulkan_enable2_SPEC_VERSION;
+
+	return enumerate(extensions, 1, propertyCapacityInput, propertyCountOutput, properties);
+}
+
+XrResult XRAPI_CALL xrCreateInstance(const XrInstanceCreateInfo* createInfo, XrInstance* instance) {
+
+	if (createInfo->type != XR_TYPE_INSTANCE_CREATE_INFO) return XR_ERROR_VALIDATION_FAILURE;
+
+	auto apiVersion = createInfo->applicationInfo.apiVersion;
+	if (XR_VERSION_MAJOR(apiVersion) != 1 || XR_VERSION_MINOR(apiVersion) != 0) return XR_ERROR_API_VERSION_UNSUPPORTED;
+
+	for (auto i = 0u; i < createInfo->enabledExtensionCount; ++i) {
+		if (std::strcmp(createInfo->enabledExtensionNames[i], XR_KHR_VULKAN_ENABLE2_EXTENSION_NAME)) {
+			return XR_ERROR_EXTENSION_NOT_PRESENT;
+		}
+	}
+
+	*instance = (XrInstance) new MockInstance(getDisplayPeriod());
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrDestroyInstance(XrInstance instance) {
+
+	delete fromHandle<MockInstance>(instance);
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrGetInstanceProperties(XrInstance instance, XrInstanceProperties* instanceProperties) {
+
+	instanceProperties->runtimeVersion = XR_MAKE_VERSION(0, 1, 0);
+	std::strcpy(instanceProperties->runtimeName, "dawnxr mock runtime");
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrPollEvent(XrInstance instance, XrEventDataBuffer* eventData) {
+
+	auto mockInstance = fromHandle<MockInstance>(instance);
+	std::lock_guard<std::mutex> lock(mockInstance->mutex);
+
+	if (mockInstance->events.empty()) return XR_EVENT_UNAVAILABLE;
+
+	*eventData = mockInstance->events.front();
+	mockInstance->events.pop_front();
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrResultToString(XrInstance instance, XrResult value, char buffer[XR_MAX_RESULT_STRING_SIZE]) {
+
+#define XR_MOCK_ENUM_CASE(NAME, VALUE)                                                                                         \
+	case VALUE:                                                                                                                \
+		std::strcpy(buffer, #NAME);                                                                                            \
+		return XR_SUCCESS;
+
+	switch (value) {
+		XR_LIST_ENUM_XrResult(XR_MOCK_ENUM_CASE)
+	default:
+		break;
+	}
+	auto kind = XR_SUCCEEDED(value) ? "SUCCESS" : "FAILURE";
+	std::snprintf(buffer, XR_MAX_RESULT_STRING_SIZE, "XR_UNKNOWN_%s_%d", kind, (int)value);
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrStructureTypeToString(XrInstance instance, XrStructureType value,
+											char buffer[XR_MAX_STRUCTURE_NAME_SIZE]) {
+
+	switch (value) {
+		XR_LIST_ENUM_XrStructureType(XR_MOCK_ENUM_CASE)
+	default:
+		break;
+	}
+#undef XR_MOCK_ENUM_CASE
+	std::snprintf(buffer, XR_MAX_STRUCTURE_NAME_SIZE, "XR_UNKNOWN_STRUCTURE_TYPE_%d", (int)value);
+
+	return XR_SUCCESS;
+}
+
+// ***** System *****
+
+XrResult XRAPI_CALL xrGetSystem(XrInstance instance, const XrSystemGetInfo* getInfo, XrSystemId* system) {
+
+	if (getInfo->formFactor != XR_FORM_FACTOR_HEAD_MOUNTED_DISPLAY) return XR_ERROR_FORM_FACTOR_UNSUPPORTED;
+
+	*system = systemId;
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrGetSystemProperties(XrInstance instance, XrSystemId system, XrSystemProperties* properties) {
+
+	if (system != systemId) return XR_ERROR_SYSTEM_INVALID;
+
+	properties->systemId = systemId;
+	properties->vendorId = 0;
+	std::strcpy(properties->systemName, "dawnxr mock HMD");
+	properties->graphicsProperties = {4096, 4096, XR_MIN_COMPOSITION_LAYERS_SUPPORTED};
+	properties->trackingProperties = {XR_TRUE, XR_TRUE};
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrEnumerateEnvironmentBlendModes(XrInstance instance, XrSystemId system,
+													 XrViewConfigurationType viewConfigurationType,
+													 uint32_t environmentBlendModeCapacityInput,
+													 uint32_t* environmentBlendModeCountOutput,
+													 XrEnvironmentBlendMode* environmentBlendModes) {
+
+	if (system != systemId) return XR_ERROR_SYSTEM_INVALID;
+
+	XrEnvironmentBlendMode modes[] = {XR_ENVIRONMENT_BLEND_MODE_OPAQUE};
+
+	return enumerate(modes, 1, environmentBlendModeCapacityInput, environmentBlendModeCountOutput,
+					 environmentBlendModes);
+}
+
+XrResult XRAPI_CALL xrEnumerateViewConfigurations(XrInstance instance, XrSystemId system,
+												  uint32_t viewConfigurationTypeCapacityInput,
+												  uint32_t* viewConfigurationTypeCountOutput,
+												  XrViewConfigurationType* viewConfigurationTypes) {
+
+	if (system != systemId) return XR_ERROR_SYSTEM_INVALID;
+
+	XrViewConfigurationType types[] = {XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO};
+
+	return enumerate(types, 1, viewConfigurationTypeCapacityInput, viewConfigurationTypeCountOutput,
+					 viewConfigurationTypes);
+}
+
+XrResult XRAPI_CALL xrGetViewConfigurationProperties(XrInstance instance, XrSystemId system,
+													 XrViewConfigurationType viewConfigurationType,
+													 XrViewConfigurationProperties* configurationProperties) {
+
+	if (system != systemId) return XR_ERROR_SYSTEM_INVALID;
+	if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+		return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+	}
+
+	configurationProperties->viewConfigurationType = viewConfigurationType;
+	configurationProperties->fovMutable = XR_FALSE;
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrEnumerateViewConfigurationViews(XrInstance instance, XrSystemId system,
+													  XrViewConfigurationType viewConfigurationType,
+													  uint32_t viewCapacityInput, uint32_t* viewCountOutput,
+													  XrViewConfigurationView* views) {
+
+	if (system != systemId) return XR_ERROR_SYSTEM_INVALID;
+	if (viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+		return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+	}
+
+	XrViewConfigurationView view{XR_TYPE_VIEW_CONFIGURATION_VIEW};
+	view.recommendedImageRectWidth = viewWidth;
+	view.maxImageRectWidth = 4096;
+	view.recommendedImageRectHeight = viewHeight;
+	view.maxImageRectHeight = 4096;
+	view.recommendedSwapchainSampleCount = 1;
+	view.maxSwapchainSampleCount = 4;
+	XrViewConfigurationView configViews[] = {view, view};
+
+	return enumerate(configViews, 2, viewCapacityInput, viewCountOutput, views);
+}
+
+// ***** Session *****
+
+XrResult XRAPI_CALL xrCreateSession(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session) {
+
+	auto mockInstance = fromHandle<MockInstance>(instance);
+
+	if (createInfo->systemId != systemId) return XR_ERROR_SYSTEM_INVALID;
+
+	// XrGraphicsBindingVulkan2KHR is an alias for XrGraphicsBindingVulkanKHR
+	auto binding = (const XrGraphicsBindingVulkan2KHR*)createInfo->next;
+	if (!binding || binding->type != XR_TYPE_GRAPHICS_BINDING_VULKAN2_KHR) return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+
+	PFN_vkGetInstanceProcAddr getInstanceProcAddr;
+	{
+		std::lock_guard<std::mutex> lock(mockInstance->mutex);
+		if (!mockInstance->requirementsQueried) return XR_ERROR_GRAPHICS_REQUIREMENTS_CALL_MISSING;
+		getInstanceProcAddr = mockInstance->getInstanceProcAddr;
+	}
+	// Only the enable2 path, where the app's Vulkan instance was created through us.
+	if (!getInstanceProcAddr) return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+
+	auto mockSession = std::make_unique<MockSession>(mockInstance, *binding);
+
+#define VK_MOCK_INSTANCE_PROC(FUNCID)                                                                                          \
+	mockSession->FUNCID = (PFN_##FUNCID)getInstanceProcAddr(binding->instance, #FUNCID);                                       \
+	if (!mockSession->FUNCID) return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+	VK_MOCK_INSTANCE_PROCS(VK_MOCK_INSTANCE_PROC)
+#undef VK_MOCK_INSTANCE_PROC
+
+#define VK_MOCK_DEVICE_PROC(FUNCID)                                                                                            \
+	mockSession->FUNCID = (PFN_##FUNCID)mockSession->vkGetDeviceProcAddr(binding->device, #FUNCID);                            \
+	if (!mockSession->FUNCID) return XR_ERROR_GRAPHICS_DEVICE_INVALID;
+	VK_MOCK_DEVICE_PROCS(VK_MOCK_DEVICE_PROC)
+#undef VK_MOCK_DEVICE_PROC
+
+	mockSession->vkGetPhysicalDeviceMemoryProperties(binding->physicalDevice, &mockSession->memoryProps);
+	mockSession->vkGetDeviceQueue(binding->device, binding->queueFamilyIndex, binding->queueIndex, &mockSession->queue);
+
+	*session = (XrSession)mockSession.release();
+
+	// No real headset to wait for, so the session is ready straight away.
+	auto created = fromHandle<MockSession>(*session);
+	std::lock_guard<std::mutex> lock(created->mutex);
+	created->setState(XR_SESSION_STATE_IDLE);
+	created->setState(XR_SESSION_STATE_READY);
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrDestroySession(XrSession session) {
+
+	std::unique_ptr<MockSession> mockSession(fromHandle<MockSession>(session));
+
+	// Destroying a session destroys its swapchains.
+	if (!mockSession->swapchains.empty()) mockSession->vkDeviceWaitIdle(mockSession->binding.device);
+	for (auto swapchain : mockSession->swapchains) delete swapchain;
+
+	if (mockSession->commandPool) {
+		mockSession->vkDestroyCommandPool(mockSession->binding.device, mockSession->commandPool, nullptr);
+	}
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrBeginSession(XrSession session, const XrSessionBeginInfo* beginInfo) {
+
+	auto mockSession = fromHandle<MockSession>(session);
+	std::lock_guard<std::mutex> lock(mockSession->mutex);
+
+	if (mockSession->running) return XR_ERROR_SESSION_RUNNING;
+	if (mockSession->state != XR_SESSION_STATE_READY) return XR_ERROR_SESSION_NOT_READY;
+	if (beginInfo->primaryViewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+		return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+	}
+
+	mockSession->running = true;
+	mockSession->setState(XR_SESSION_STATE_SYNCHRONIZED);
+	mockSession->setState(XR_SESSION_STATE_VISIBLE);
+	mockSession->setState(XR_SESSION_STATE_FOCUSED);
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrEndSession(XrSession session) {
+
+	auto mockSession = fromHandle<MockSession>(session);
+	std::lock_guard<std::mutex> lock(mockSession->mutex);
+
+	if (!mockSession->running) return XR_ERROR_SESSION_NOT_RUNNING;
+	if (mockSession->state != XR_SESSION_STATE_STOPPING) return XR_ERROR_SESSION_NOT_STOPPING;
+
+	mockSession->running = false;
+	mockSession->setState(XR_SESSION_STATE_IDLE);
+	mockSession->setState(XR_SESSION_STATE_EXITING);
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrRequestExitSession(XrSession session) {
+
+	auto mockSession = fromHandle<MockSession>(session);
+	std::lock_guard<std::mutex> lock(mockSession->mutex);
+
+	if (!mockSession->running) return XR_ERROR_SESSION_NOT_RUNNING;
+
+	mockSession->setState(XR_SESSION_STATE_VISIBLE);
+	mockSession->setState(XR_SESSION_STATE_SYNCHRONIZED);
+	mockSession->setState(XR_SESSION_STATE_STOPPING);
+
+	return XR_SUCCESS;
+}
+
+// ***** Spaces *****
+
+XrResult XRAPI_CALL xrCreateReferenceSpace(XrSession session, const XrReferenceSpaceCreateInfo* createInfo,
+										   XrSpace* space) {
+
+	*space = (XrSpace) new MockSpace{fromHandle<MockSession>(session)};
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrDestroySpace(XrSpace space) {
+
+	delete fromHandle<MockSpace>(space);
+
+	return XR_SUCCESS;
+}
+
+// A head sitting still at the origin, with a typical IPD and FOV.
+XrResult XRAPI_CALL xrLocateViews(XrSession session, const XrViewLocateInfo* viewLocateInfo, XrViewState* viewState,
+								  uint32_t viewCapacityInput, uint32_t* viewCountOutput, XrView* views) {
+
+	if (viewLocateInfo->viewConfigurationType != XR_VIEW_CONFIGURATION_TYPE_PRIMARY_STEREO) {
+		return XR_ERROR_VIEW_CONFIGURATION_TYPE_UNSUPPORTED;
+	}
+
+	*viewCountOutput = 2;
+	if (!viewCapacityInput) return XR_SUCCESS;
+	if (viewCapacityInput < 2) return XR_ERROR_SIZE_INSUFFICIENT;
+
+	viewState->viewStateFlags = XR_VIEW_STATE_ORIENTATION_VALID_BIT | XR_VIEW_STATE_POSITION_VALID_BIT |
+								XR_VIEW_STATE_ORIENTATION_TRACKED_BIT | XR_VIEW_STATE_POSITION_TRACKED_BIT;
+
+	for (auto i = 0; i < 2; ++i) {
+		views[i].pose = {{0, 0, 0, 1}, {i ? 0.032f : -0.032f, 0, 0}};
+		views[i].fov = {-0.8f, 0.8f, 0.8f, -0.8f};
+	}
+
+	return XR_SUCCESS;
+}
+
+// ***** Frames *****
+
+XrResult XRAPI_CALL xrWaitFrame(XrSession session, const XrFrameWaitInfo* frameWaitInfo, XrFrameState* frameState) {
+
+	auto mockSession = fromHandle<MockSession>(session);
+	auto displayPeriod = mockSession->instance->displayPeriod;
+
+	std::unique_lock<std::mutex> lock(mockSession->mutex);
+	if (!mockSession->running) return XR_ERROR_SESSION_NOT_RUNNING;
+
+	// Blocks until the previous frame has begun, which may be on another thread.
+	mockSession->frameBegun.wait(lock, [=] { return mockSession->waitedFrames == mockSession->begunFrames; });
+
+	auto now = getTime();
+	auto vsyncTime = displayPeriod ? std::max(mockSession->lastVsyncTime + displayPeriod, now) : now;
+	mockSession->lastVsyncTime = vsyncTime;
+	++mockSession->waitedFrames;
+
+	auto shouldRender =
+		mockSession->state == XR_SESSION_STATE_VISIBLE || mockSession->state == XR_SESSION_STATE_FOCUSED;
+	lock.unlock();
+
+	if (vsyncTime > now) std::this_thread::sleep_for(std::chrono::nanoseconds(vsyncTime - now));
+
+	// Frames are displayed a period after the vsync they're waited for, as with a real compositor.
+	frameState->predictedDisplayPeriod = displayPeriod ? displayPeriod : 11111111;
+	frameState->predictedDisplayTime = vsyncTime + frameState->predictedDisplayPeriod;
+	frameState->shouldRender = shouldRender;
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrBeginFrame(XrSession session, const XrFrameBeginInfo* frameBeginInfo) {
+
+	auto mockSession = fromHandle<MockSession>(session);
+	std::lock_guard<std::mutex> lock(mockSession->mutex);
+
+	if (!mockSession->running) return XR_ERROR_SESSION_NOT_RUNNING;
+	if (mockSession->begunFrames == mockSession->waitedFrames) return XR_ERROR_CALL_ORDER_INVALID;
+
+	auto discarded = mockSession->frameInProgress;
+	mockSession->frameInProgress = true;
+	++mockSession->begunFrames;
+	mockSession->frameBegun.notify_all();
+
+	return discarded ? XR_FRAME_DISCARDED : XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrEndFrame(XrSession session, const XrFrameEndInfo* frameEndInfo) {
+
+	auto mockSession = fromHandle<MockSession>(session);
+	std::lock_guard<std::mutex> lock(mockSession->mutex);
+
+	if (!mockSession->running) return XR_ERROR_SESSION_NOT_RUNNING;
+	if (!mockSession->frameInProgress) return XR_ERROR_CALL_ORDER_INVALID;
+	if (frameEndInfo->displayTime <= 0) return XR_ERROR_TIME_INVALID;
+	if (frameEndInfo->environmentBlendMode != XR_ENVIRONMENT_BLEND_MODE_OPAQUE) {
+		return XR_ERROR_ENVIRONMENT_BLEND_MODE_UNSUPPORTED;
+	}
+	if (frameEndInfo->layerCount > XR_MIN_COMPOSITION_LAYERS_SUPPORTED) return XR_ERROR_LAYER_LIMIT_EXCEEDED;
+	for (auto i = 0u; i < frameEndInfo->layerCount; ++i) {
+		if (!frameEndInfo->layers[i]) return XR_ERROR_LAYER_INVALID;
+	}
+
+	mockSession->frameInProgress = false;
+
+	return XR_SUCCESS;
+}
+
+// ***** Swapchains *****
+
+XrResult XRAPI_CALL xrEnumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInput,
+												uint32_t* formatCountOutput, int64_t* formats) {
+
+	return enumerate(swapchainFormats, (uint32_t)std::size(swapchainFormats), formatCapacityInput, formatCountOutput,
+					 formats);
+}
+
+XrResult XRAPI_CALL xrCreateSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo,
+									  XrSwapchain* swapchain) {
+
+	auto mockSession = fromHandle<MockSession>(session);
+	auto device = mockSession->binding.device;
+
+	if (std::find(std::begin(swapchainFormats), std::end(swapchainFormats), createInfo->format) ==
+		std::end(swapchainFormats)) {
+		return XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+	}
+	if (!createInfo->width || !createInfo->height || createInfo->width > 4096 || createInfo->height > 4096 ||
+		createInfo->faceCount != 1 || !createInfo->arraySize || !createInfo->mipCount ||
+		(createInfo->sampleCount != 1 && createInfo->sampleCount != 4)) {
+		return XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	auto mockSwapchain = std::make_unique<MockSwapchain>(mockSession, *createInfo);
+
+	VkImageCreateInfo imageInfo{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+	if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_MUTABLE_FORMAT_BIT) {
+		imageInfo.flags = VK_IMAGE_CREATE_MUTABLE_FORMAT_BIT;
+	}
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = (VkFormat)createInfo->format;
+	imageInfo.extent = {createInfo->width, createInfo->height, 1};
+	imageInfo.mipLevels = createInfo->mipCount;
+	imageInfo.arrayLayers = createInfo->arraySize;
+	imageInfo.samples = (VkSampleCountFlagBits)createInfo->sampleCount;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = getImageUsage(createInfo->usageFlags);
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+	// Most runtimes use 3 images, static images only need 1.
+	uint32_t n = (createInfo->createFlags & XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT) ? 1 : 3;
+
+	for (auto i = 0u; i < n; ++i) {
+		VkImage image;
+		if (mockSession->vkCreateImage(device, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+			return XR_ERROR_RUNTIME_FAILURE;
+		}
+		mockSwapchain->images.push_back(image);
+
+		VkMemoryRequirements memReqs;
+		mockSession->vkGetImageMemoryRequirements(device, image, &memReqs);
+
+		VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+		allocInfo.allocationSize = memReqs.size;
+		allocInfo.memoryTypeIndex = findMemoryType(mockSession->memoryProps, memReqs.memoryTypeBits);
+		if (allocInfo.memoryTypeIndex == ~0u) return XR_ERROR_RUNTIME_FAILURE;
+
+		VkDeviceMemory memory;
+		if (mockSession->vkAllocateMemory(device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+			return XR_ERROR_RUNTIME_FAILURE;
+		}
+		mockSwapchain->memory.push_back(memory);
+
+		if (mockSession->vkBindImageMemory(device, image, memory, 0) != VK_SUCCESS) return XR_ERROR_RUNTIME_FAILURE;
+	}
+
+	std::lock_guard<std::mutex> lock(mockSession->mutex);
+
+	if (transitionImages(mockSession, mockSwapchain->images, *createInfo) != VK_SUCCESS) {
+		return XR_ERROR_RUNTIME_FAILURE;
+	}
+
+	mockSession->swapchains.push_back(mockSwapchain.get());
+	*swapchain = (XrSwapchain)mockSwapchain.release();
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrDestroySwapchain(XrSwapchain swapchain) {
+
+	std::unique_ptr<MockSwapchain> mockSwapchain(fromHandle<MockSwapchain>(swapchain));
+	auto mockSession = mockSwapchain->session;
+
+	std::lock_guard<std::mutex> lock(mockSession->mutex);
+
+	auto& swapchains = mockSession->swapchains;
+	swapchains.erase(std::find(swapchains.begin(), swapchains.end(), mockSwapchain.get()));
+
+	// A real compositor would hold on to the images until it's done with them, we just wait for the app's work on them.
+	mockSession->vkDeviceWaitIdle(mockSession->binding.device);
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrEnumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityInput,
+											   uint32_t* imageCountOutput, XrSwapchainImageBaseHeader* images) {
+
+	auto mockSwapchain = fromHandle<MockSwapchain>(swapchain);
+	auto n = (uint32_t)mockSwapchain->images.size();
+
+	*imageCountOutput = n;
+	if (!imageCapacityInput) return XR_SUCCESS;
+	if (imageCapacityInput < n) return XR_ERROR_SIZE_INSUFFICIENT;
+
+	// XrSwapchainImageVulkan2KHR is an alias for XrSwapchainImageVulkanKHR
+	auto vulkanImages = (XrSwapchainImageVulkan2KHR*)images;
+	for (auto i = 0u; i < n; ++i) {
+		if (vulkanImages[i].type != XR_TYPE_SWAPCHAIN_IMAGE_VULKAN2_KHR) return XR_ERROR_VALIDATION_FAILURE;
+		vulkanImages[i].image = mockSwapchain->images[i];
+	}
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrAcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo,
+											uint32_t* index) {
+
+	auto mockSwapchain = fromHandle<MockSwapchain>(swapchain);
+	auto n = (uint32_t)mockSwapchain->images.size();
+
+	if (mockSwapchain->acquired.size() == n) return XR_ERROR_CALL_ORDER_INVALID;
+	if ((mockSwapchain->createInfo.createFlags & XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT) && mockSwapchain->everAcquired) {
+		return XR_ERROR_CALL_ORDER_INVALID;
+	}
+
+	*index = mockSwapchain->nextImage;
+	mockSwapchain->nextImage = (mockSwapchain->nextImage + 1) % n;
+	mockSwapchain->acquired.push_back(*index);
+	mockSwapchain->everAcquired = true;
+
+	return XR_SUCCESS;
+}
+
+// Nothing reads the images, so they're always ready to be written.
+XrResult XRAPI_CALL xrWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo) {
+
+	auto mockSwapchain = fromHandle<MockSwapchain>(swapchain);
+
+	if (mockSwapchain->waitedCount == mockSwapchain->acquired.size()) return XR_ERROR_CALL_ORDER_INVALID;
+	++mockSwapchain->waitedCount;
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo) {
+
+	auto mockSwapchain = fromHandle<MockSwapchain>(swapchain);
+
+	if (!mockSwapchain->waitedCount) return XR_ERROR_CALL_ORDER_INVALID;
+	--mockSwapchain->waitedCount;
+	mockSwapchain->acquired.pop_front();
+
+	return XR_SUCCESS;
+}
+
+// ***** XR_KHR_vulkan_enable2 *****
+
+XrResult XRAPI_CALL xrGetVulkanGraphicsRequirements2KHR(XrInstance instance, XrSystemId system,
+														XrGraphicsRequirementsVulkan2KHR* graphicsRequirements) {
+
+	if (system != systemId) return XR_ERROR_SYSTEM_INVALID;
+
+	graphicsRequirements->minApiVersionSupported = XR_MAKE_VERSION(1, 0, 0);
+	graphicsRequirements->maxApiVersionSupported = XR_MAKE_VERSION(1, 3, 0);
+
+	auto mockInstance = fromHandle<MockInstance>(instance);
+	std::lock_guard<std::mutex> lock(mockInstance->mutex);
+	mockInstance->requirementsQueried = true;
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrCreateVulkanInstanceKHR(XrInstance instance, const XrVulkanInstanceCreateInfoKHR* createInfo,
+											  VkInstance* vulkanInstance, VkResult* vulkanResult) {
+
+	if (createInfo->systemId != systemId) return XR_ERROR_SYSTEM_INVALID;
+
+	auto getInstanceProcAddr = createInfo->pfnGetInstanceProcAddr;
+	auto vkCreateInstance = (PFN_vkCreateInstance)getInstanceProcAddr(VK_NULL_HANDLE, "vkCreateInstance");
+	if (!vkCreateInstance) return XR_ERROR_RUNTIME_FAILURE;
+
+	// No extensions needed, nothing is shared with another process or API.
+	*vulkanResult = vkCreateInstance(createInfo->vulkanCreateInfo, createInfo->vulkanAllocator, vulkanInstance);
+	if (*vulkanResult != VK_SUCCESS) return XR_SUCCESS;
+
+	auto mockInstance = fromHandle<MockInstance>(instance);
+	std::lock_guard<std::mutex> lock(mockInstance->mutex);
+	mockInstance->getInstanceProcAddr = getInstanceProcAddr;
+	mockInstance->vkInstance = *vulkanInstance;
+
+	return XR_SUCCESS;
+}
+
+// Prefers a CPU device, so the numbers don't depend on whatever GPU the machine happens to have.
+XrResult XRAPI_CALL xrGetVulkanGraphicsDevice2KHR(XrInstance instance, const XrVulkanGraphicsDeviceGetInfoKHR* getInfo,
+												  VkPhysicalDevice* vulkanPhysicalDevice) {
+
+	if (getInfo->systemId != systemId) return XR_ERROR_SYSTEM_INVALID;
+
+	auto mockInstance = fromHandle<MockInstance>(instance);
+	PFN_vkGetInstanceProcAddr getInstanceProcAddr;
+	{
+		std::lock_guard<std::mutex> lock(mockInstance->mutex);
+		if (mockInstance->vkInstance != getInfo->vulkanInstance) return XR_ERROR_VALIDATION_FAILURE;
+		getInstanceProcAddr = mockInstance->getInstanceProcAddr;
+	}
+
+	auto vkInstance = getInfo->vulkanInstance;
+	auto vkEnumeratePhysicalDevices =
+		(PFN_vkEnumeratePhysicalDevices)getInstanceProcAddr(vkInstance, "vkEnumeratePhysicalDevices");
+	auto vkGetPhysicalDeviceProperties =
+		(PFN_vkGetPhysicalDeviceProperties)getInstanceProcAddr(vkInstance, "vkGetPhysicalDeviceProperties");
+	if (!vkEnumeratePhysicalDevices || !vkGetPhysicalDeviceProperties) return XR_ERROR_RUNTIME_FAILURE;
+
+	uint32_t n = 0;
+	vkEnumeratePhysicalDevices(vkInstance, &n, nullptr);
+	std::vector<VkPhysicalDevice> physicalDevices(n);
+	vkEnumeratePhysicalDevices(vkInstance, &n, physicalDevices.data());
+	if (!n) return XR_ERROR_RUNTIME_FAILURE;
+
+	*vulkanPhysicalDevice = physicalDevices[0];
+	for (auto physicalDevice : physicalDevices) {
+		VkPhysicalDeviceProperties props;
+		vkGetPhysicalDeviceProperties(physicalDevice, &props);
+		if (props.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) {
+			*vulkanPhysicalDevice = physicalDevice;
+			break;
+		}
+	}
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrCreateVulkanDeviceKHR(XrInstance instance, const XrVulkanDeviceCreateInfoKHR* createInfo,
+											VkDevice* vulkanDevice, VkResult* vulkanResult) {
+
+	if (createInfo->systemId != systemId) return XR_ERROR_SYSTEM_INVALID;
+
+	auto mockInstance = fromHandle<MockInstance>(instance);
+	VkInstance vkInstance;
+	{
+		std::lock_guard<std::mutex> lock(mockInstance->mutex);
+		vkInstance = mockInstance->vkInstance;
+	}
+	if (!vkInstance) return XR_ERROR_CALL_ORDER_INVALID;
+
+	auto vkCreateDevice = (PFN_vkCreateDevice)createInfo->pfnGetInstanceProcAddr(vkInstance, "vkCreateDevice");
+	if (!vkCreateDevice) return XR_ERROR_RUNTIME_FAILURE;
+
+	*vulkanResult =
+		vkCreateDevice(createInfo->vulkanPhysicalDevice, createInfo->vulkanCreateInfo, createInfo->vulkanAllocator,
+					   vulkanDevice);
+
+	return XR_SUCCESS;
+}
+
+} // namespace mock
+
+// ***** Loader interface *****
+
+XrResult XRAPI_CALL mockGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function) {
+
+	*function = nullptr;
+
+	if (!std::strcmp(name, "xrGetInstanceProcAddr")) {
+		*function = (PFN_xrVoidFunction)mockGetInstanceProcAddr;
+		return XR_SUCCESS;
+	}
+
+	// Only these can be called without an instance.
+	if (!instance && std::strcmp(name, "xrEnumerateInstanceExtensionProperties") &&
+		std::strcmp(name, "xrCreateInstance")) {
+		return XR_ERROR_HANDLE_INVALID;
+	}
+
+	// Assigning to the PFN type first checks each entry point's signature.
+#define XR_MOCK_PROC(FUNCID)                                                                                                   \
+	if (!std::strcmp(name, #FUNCID)) {                                                                                         \
+		PFN_##FUNCID proc = mock::FUNCID;                                                                                      \
+		*function = (PFN_xrVoidFunction)proc;                                                                                  \
+		return XR_SUCCESS;                                                                                                     \
+	}
+	XR_MOCK_PROCS(XR_MOCK_PROC)
+#undef XR_MOCK_PROC
+
+	return XR_ERROR_FUNCTION_UNSUPPORTED;
+}
+
+} // namespace
+
+extern "C" DAWNXR_MOCK_EXPORT XrResult XRAPI_CALL xrNegotiateLoaderRuntimeInterface(
+	const XrNegotiateLoaderInfo* loaderInfo, XrNegotiateRuntimeRequest* runtimeRequest) {
+
+	if (!loaderInfo || loaderInfo->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO ||
+		loaderInfo->minInterfaceVersion > XR_CURRENT_LOADER_RUNTIME_VERSION ||
+		loaderInfo->maxInterfaceVersion < XR_CURRENT_LOADER_RUNTIME_VERSION) {
+		return XR_ERROR_INITIALIZATION_FAILED;
+	}
+	if (!runtimeRequest || runtimeRequest->structType != XR_LOADER_INTERFACE_STRUCT_RUNTIME_REQUEST) {
+		return XR_ERROR_INITIALIZATION_FAILED;
+	}
+
+	runtimeRequest->runtimeInterfaceVersion = XR_CURRENT_LOADER_RUNTIME_VERSION;
+	runtimeRequest->runtimeApiVersion = XR_MAKE_VERSION(1, 0, XR_VERSION_PATCH(XR_CURRENT_API_VERSION));
+	runtimeRequest->getInstanceProcAddr = mockGetInstanceProcAddr;
+
+	return XR_SUCCESS;
+}
@@ -1,41 +1,531 @@
 #include "dawnxr_internal.h"
+#include "dawnxr_handlemap.h"
 
-#include <unordered_map>
-
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <memory>
+#include <thread>
 
 using namespace dawnxr::internal;
 
 namespace {
 
+struct DynamicResolution {
+	XrDuration const targetGpuTime;
+	float const minScale;
+	float const maxScale;
+	float scale;
+};
+
+// Multisampled color textures shared by a session's MSAA swapchains with the same format and size. Multisampled
+// textures can't have array layers, so there's one single layer texture per swapchain array layer.
+struct MsaaTarget {
+	Session* const session;
+	wgpu::TextureFormat const format;
+	uint32_t const width;
+	uint32_t const height;
+	uint32_t const arraySize;
+	uint32_t const sampleCount;
+	std::vector<wgpu::Texture> const textures;
+	uint64_t const memoryUsage;
+
+	~MsaaTarget() {
+		for (auto& texture : textures) texture.Destroy();
+		session->memoryUsage -= memoryUsage;
+	}
+};
+
 struct Swapchain {
 	XrSwapchain const backendSwapchain;
 	Session* const session;
-	std::vector<wgpu::Texture> const images;
+	XrSwapchainCreateInfo const createInfo; // Pooling key, next is always nullptr
+	std::shared_ptr<MsaaTarget> const msaaTarget;
+	std::vector<SwapchainImageViewsDawn> const images;
+	uint64_t const memoryUsage; // Of the images, upload and readback count their own
+	std::unique_ptr<std::atomic<uint64_t>[]> const releaseSerials; // Per image completion serial of its last release
+	std::unique_ptr<GpuTimer> gpuTimer;
+	std::optional<DynamicResolution> dynamicResolution;
+	std::vector<uint32_t> acquiredImages; // Acquired but not yet released, oldest first
+	bool generateMips = false;
+	std::vector<std::vector<Blitter::Pass>> mipPasses; // Per image, created when mip generation is first enabled
+	std::unique_ptr<Upload> upload;
+	std::unique_ptr<Readback> readback;
+	std::unique_ptr<Mirror> mirror;
+};
+
+// Swapchains destroyed by the app but kept alive so a later createSwapchain with the same create info can reuse them,
+// oldest first.
+struct SwapchainPool {
+	uint32_t capacity = 0;
+	std::vector<std::unique_ptr<Swapchain>> swapchains;
 };
 
-std::unordered_map<XrSession, Session*> g_sessions;
+bool isDepthFormat(wgpu::TextureFormat format) {
+	switch (format) {
+	case wgpu::TextureFormat::Depth16Unorm:
+	case wgpu::TextureFormat::Depth24Plus:
+	case wgpu::TextureFormat::Depth24PlusStencil8:
+	case wgpu::TextureFormat::Depth32Float:
+	case wgpu::TextureFormat::Depth32FloatStencil8:
+		return true;
+	default:
+		return false;
+	}
+}
+
+void encodeLoadStorePass(const wgpu::CommandEncoder& encoder, const wgpu::TextureView& view) {
+
+	wgpu::RenderPassColorAttachment colorAttachment{};
+	colorAttachment.view = view;
+	colorAttachment.loadOp = wgpu::LoadOp::Load;
+	colorAttachment.storeOp = wgpu::StoreOp::Store;
+
+	wgpu::RenderPassDescriptor passDesc{};
+	passDesc.colorAttachmentCount = 1;
+	passDesc.colorAttachments = &colorAttachment;
+
+	encoder.BeginRenderPass(&passDesc).End();
+}
+
+// Estimates the memory held by swapchain images, ignoring any padding/compression the driver adds.
+uint64_t estimateImageMemory(const XrSwapchainCreateInfo* createInfo, size_t imageCount) {
+
+	uint64_t texels = 0;
+	for (auto mip = 0u; mip < createInfo->mipCount; ++mip) {
+		texels += (uint64_t)std::max(createInfo->width >> mip, 1u) * std::max(createInfo->height >> mip, 1u);
+	}
+
+	return texels * createInfo->arraySize * createInfo->sampleCount * getTexelSize((wgpu::TextureFormat)createInfo->format) *
+		   imageCount;
+}
+
+bool isSameSwapchain(const XrSwapchainCreateInfo& a, const XrSwapchainCreateInfo& b) {
+	return a.createFlags == b.createFlags && a.usageFlags == b.usageFlags && a.format == b.format &&
+		   a.sampleCount == b.sampleCount && a.width == b.width && a.height == b.height && a.faceCount == b.faceCount &&
+		   a.arraySize == b.arraySize && a.mipCount == b.mipCount;
+}
+
+// GPU time scales roughly with pixel count, ie: with scale squared.
+void updateDynamicResolution(DynamicResolution& dynamicResolution, XrDuration gpuTime) {
+
+	auto scale = dynamicResolution.scale * std::sqrt((float)dynamicResolution.targetGpuTime / (float)gpuTime);
+
+	// Drop quickly when over budget so we don't miss frames, recover slowly so we don't oscillate.
+	auto rate = scale < dynamicResolution.scale ? 0.5f : 0.1f;
+
+	dynamicResolution.scale = std::clamp(dynamicResolution.scale + (scale - dynamicResolution.scale) * rate,
+										 dynamicResolution.minScale, dynamicResolution.maxScale);
+}
+
+// Whether waitSwapchainImage/releaseSwapchainImage time the GPU work on the swapchain's images.
+bool isGpuTimed(const Swapchain& swapchain) {
+	return g_timingEnabled.load(std::memory_order_relaxed) || swapchain.dynamicResolution;
+}
+
+// The sub-rect rendered to this frame, see getDynamicResolutionRect.
+XrRect2Di getImageRect(const Swapchain& swapchain) {
+
+	auto& createInfo = swapchain.createInfo;
+	auto scale = swapchain.dynamicResolution ? swapchain.dynamicResolution->scale : 1.0f;
+
+	XrRect2Di rect{};
+	rect.extent.width = std::max((int32_t)std::lround(createInfo.width * scale), 1);
+	rect.extent.height = std::max((int32_t)std::lround(createInfo.height * scale), 1);
+
+	return rect;
+}
+
+std::vector<SwapchainImageViewsDawn> createImageViews(const std::vector<wgpu::Texture>& textures,
+													  const MsaaTarget* msaaTarget) {
+
+	std::vector<SwapchainImageViewsDawn> images(textures.size());
+
+	// Every image renders through the same MSAA target. There's no array view of a layered one, as its layers are
+	// separate textures.
+	wgpu::TextureView msaaTextureView;
+	std::vector<wgpu::TextureView> msaaLayerViews;
+	if (msaaTarget) {
+		for (auto& texture : msaaTarget->textures) msaaLayerViews.push_back(texture.CreateView());
+		if (msaaTarget->arraySize == 1) msaaTextureView = msaaLayerViews[0];
+	}
+
+	for (auto i = 0u; i < textures.size(); ++i) {
+		auto& image = images[i];
+		image.texture = textures[i];
+
+		auto mipCount = image.texture.GetMipLevelCount();
+		auto layerCount = image.texture.GetDepthOrArrayLayers();
+		auto dimension = layerCount > 1 ? wgpu::TextureViewDimension::e2DArray : wgpu::TextureViewDimension::e2D;
+
+		wgpu::TextureViewDescriptor viewDesc{};
+		viewDesc.dimension = dimension;
+		image.textureView = image.texture.CreateView(&viewDesc);
+
+		if (mipCount == 1) {
+			image.mipViews.push_back(image.textureView);
+		} else {
+			for (auto mip = 0u; mip < mipCount; ++mip) {
+				wgpu::TextureViewDescriptor mipDesc{};
+				mipDesc.dimension = dimension;
+				mipDesc.baseMipLevel = mip;
+				mipDesc.mipLevelCount = 1;
+				image.mipViews.push_back(image.texture.CreateView(&mipDesc));
+			}
+		}
+
+		if (layerCount == 1) {
+			image.layerViews.push_back(image.mipViews[0]);
+		} else {
+			for (auto layer = 0u; layer < layerCount; ++layer) {
+				wgpu::TextureViewDescriptor layerDesc{};
+				layerDesc.dimension = wgpu::TextureViewDimension::e2D;
+				layerDesc.baseMipLevel = 0;
+				layerDesc.mipLevelCount = 1;
+				layerDesc.baseArrayLayer = layer;
+				layerDesc.arrayLayerCount = 1;
+				image.layerViews.push_back(image.texture.CreateView(&layerDesc));
+			}
+		}
+
+		if (isDepthFormat(image.texture.GetFormat())) {
+			wgpu::TextureViewDescriptor depthDesc{};
+			depthDesc.dimension = dimension;
+			depthDesc.aspect = wgpu::TextureAspect::DepthOnly;
+			image.depthView = image.texture.CreateView(&depthDesc);
+		}
+
+		image.msaaTextureView = msaaTextureView;
+		image.msaaLayerViews = msaaLayerViews;
+	}
+
+	return images;
+}
+
+HandleMap<XrInstance, Instance> g_instances;
 
-std::unordered_map<XrSwapchain, Swapchain*> g_swapchains;
+HandleMap<XrSession, Session> g_sessions;
+
+HandleMap<XrSwapchain, Swapchain> g_swapchains;
+
+std::mutex g_poolsMutex;
+std::unordered_map<Session*, SwapchainPool> g_pools;
+
+std::mutex g_msaaMutex;
+std::unordered_map<Session*, std::vector<std::weak_ptr<MsaaTarget>>> g_msaaTargets;
+
+// WebGPU never multisamples RGBA32Float, and RG11B10Ufloat only where it's renderable.
+bool isMultisampleSupported(const wgpu::Device& device, wgpu::TextureFormat format) {
+	switch (format) {
+	case wgpu::TextureFormat::RGBA32Float:
+		return false;
+	case wgpu::TextureFormat::RG11B10Ufloat:
+		return device.HasFeature(wgpu::FeatureName::RG11B10UfloatRenderable);
+	default:
+		return !isDepthFormat(format);
+	}
+}
+
+// The create info and format must already be validated, as dawn reports texture errors asynchronously.
+std::shared_ptr<MsaaTarget> getMsaaTarget(Session* session, const XrSwapchainCreateInfo& createInfo,
+										  uint32_t sampleCount) {
+
+	auto format = (wgpu::TextureFormat)createInfo.format;
+
+	std::lock_guard<std::mutex> lock(g_msaaMutex);
+
+	auto& targets = g_msaaTargets[session];
+	targets.erase(std::remove_if(targets.begin(), targets.end(), [](auto& target) { return target.expired(); }),
+				  targets.end());
+
+	for (auto& it : targets) {
+		auto target = it.lock();
+		if (target && target->format == format && target->width == createInfo.width &&
+			target->height == createInfo.height && target->arraySize == createInfo.arraySize &&
+			target->sampleCount == sampleCount) {
+			return target;
+		}
+	}
+
+	// Transient attachments can live in tile memory and never be backed by VRAM, as they're only ever resolved.
+	auto usage = wgpu::TextureUsage::RenderAttachment;
+	if (session->device.HasFeature(wgpu::FeatureName::TransientAttachments)) {
+		usage |= wgpu::TextureUsage::TransientAttachment;
+	}
+
+	wgpu::TextureDescriptor textureDesc{};
+	textureDesc.usage = usage;
+	textureDesc.size = {createInfo.width, createInfo.height, 1};
+	textureDesc.format = format;
+	textureDesc.sampleCount = sampleCount;
+
+	std::vector<wgpu::Texture> textures;
+	for (auto layer = 0u; layer < createInfo.arraySize; ++layer) {
+		textures.push_back(session->device.CreateTexture(&textureDesc));
+	}
+
+	auto memoryUsage = (uint64_t)createInfo.width * createInfo.height * createInfo.arraySize * sampleCount *
+					   getTexelSize(format);
+	session->memoryUsage += memoryUsage;
+
+	auto target = std::shared_ptr<MsaaTarget>(new MsaaTarget{session, format, createInfo.width, createInfo.height,
+															 createInfo.arraySize, sampleCount, textures, memoryUsage});
+	targets.push_back(target);
+
+	return target;
+}
+
+XrResult destroyBackendSwapchain(std::unique_ptr<Swapchain> dawnSwapchain) {
+
+	// Release dawn's hold on the images before the runtime frees them.
+	for (auto& image : dawnSwapchain->images) image.texture.Destroy();
+	dawnSwapchain->session->memoryUsage -= dawnSwapchain->memoryUsage;
+
+	return dawnSwapchain->session->destroySwapchain(dawnSwapchain->backendSwapchain);
+}
+
+std::unique_ptr<Swapchain> takePooledSwapchain(Session* session, const XrSwapchainCreateInfo& createInfo,
+											   uint32_t msaaSampleCount) {
+
+	std::lock_guard<std::mutex> lock(g_poolsMutex);
+
+	auto it = g_pools.find(session);
+	if (it == g_pools.end()) return {};
+
+	auto& swapchains = it->second.swapchains;
+	for (auto i = swapchains.size(); i-- > 0;) {
+		auto& msaaTarget = swapchains[i]->msaaTarget;
+		if (!isSameSwapchain(swapchains[i]->createInfo, createInfo) ||
+			(msaaTarget ? msaaTarget->sampleCount : 1) != msaaSampleCount) {
+			continue;
+		}
+		auto dawnSwapchain = std::move(swapchains[i]);
+		swapchains.erase(swapchains.begin() + i);
+		return dawnSwapchain;
+	}
+
+	return {};
+}
+
+// Destroys pooled swapchains beyond capacity, oldest first.
+void trimSwapchainPool(Session* session, uint32_t capacity) {
+
+	std::vector<std::unique_ptr<Swapchain>> evicted;
+	{
+		std::lock_guard<std::mutex> lock(g_poolsMutex);
+
+		auto it = g_pools.find(session);
+		if (it == g_pools.end()) return;
+
+		auto& swapchains = it->second.swapchains;
+		while (swapchains.size() > capacity) {
+			evicted.push_back(std::move(swapchains.front()));
+			swapchains.erase(swapchains.begin());
+		}
+		if (!capacity) g_pools.erase(it);
+	}
+
+	for (auto& dawnSwapchain : evicted) destroyBackendSwapchain(std::move(dawnSwapchain));
+}
 
 } // namespace
 
+namespace dawnxr::internal {
+
+Instance::Instance(XrInstance instance, PFN_xrGetInstanceProcAddr getInstanceProcAddr) : instance(instance) {
+#define XR_RESOLVE_PROC(FUNCID) getInstanceProcAddr(instance, #FUNCID, (PFN_xrVoidFunction*)(&FUNCID));
+	XR_CORE_PROCS(XR_RESOLVE_PROC)
+	XR_D3D12_PROCS(XR_RESOLVE_PROC)
+	XR_VULKAN_PROCS(XR_RESOLVE_PROC)
+#undef XR_RESOLVE_PROC
+}
+
+System* Instance::getSystem(XrSystemId systemId) {
+
+	std::lock_guard<std::mutex> lock(systemsMutex);
+
+	auto& system = systems[systemId];
+	if (!system) system = std::make_unique<System>(systemId);
+
+	return system.get();
+}
+
+void Instance::invalidateSystems() {
+
+	std::lock_guard<std::mutex> lock(systemsMutex);
+
+	// Systems may still be in use by other threads, so just reset them.
+	for (auto& it : systems) {
+		std::lock_guard<std::mutex> systemLock(it.second->mutex);
+		it.second->invalidate();
+	}
+}
+
+XrResult Instance::checkLost(XrResult r) {
+
+	if (r == XR_ERROR_INSTANCE_LOST) invalidateSystems();
+
+	return r;
+}
+
+Instance* getInstance(XrInstance instance, PFN_xrGetInstanceProcAddr getInstanceProcAddr) {
+
+	auto dawnInstance = g_instances.find(instance);
+	if (dawnInstance) return dawnInstance;
+
+	dawnInstance = new Instance(instance, getInstanceProcAddr);
+	if (g_instances.insert(instance, dawnInstance)) return dawnInstance;
+
+	// Lost a race with another thread.
+	delete dawnInstance;
+	return g_instances.find(instance);
+}
+
+Session* findSession(XrSession session) {
+	return g_sessions.find(session);
+}
+
+void releaseInstance(XrInstance instance) {
+
+	std::unique_ptr<Instance> dawnInstance(g_instances.erase(instance));
+	if (!dawnInstance) return;
+
+	// Destroying an instance destroys its sessions, so clean up ours first.
+	std::vector<XrSession> sessions;
+	g_sessions.forEach([&](XrSession session, Session* dawnSession) {
+		if (dawnSession->dispatch == dawnInstance.get()) sessions.push_back(session);
+	});
+	for (auto session : sessions) dawnxr::destroySession(session);
+}
+
+uint32_t getTexelSize(wgpu::TextureFormat format) {
+	switch (format) {
+	case wgpu::TextureFormat::Depth16Unorm:
+		return 2;
+	case wgpu::TextureFormat::RGBA16Float:
+	case wgpu::TextureFormat::Depth32FloatStencil8:
+		return 8;
+	case wgpu::TextureFormat::RGBA32Float:
+		return 16;
+	default:
+		return 4;
+	}
+}
+
+const wgpu::CommandEncoder& CommandBatch::get() {
+
+	if (!encoder) encoder = session->device.CreateCommandEncoder();
+
+	return encoder;
+}
+
+bool CommandBatch::submit() {
+
+	if (!encoder) return false;
+
+	auto commands = encoder.Finish();
+	session->device.GetQueue().Submit(1, &commands);
+	encoder = nullptr;
+	++session->submitCount;
+
+	return true;
+}
+
+CompletionTracker::CompletionTracker(const wgpu::Device& device)
+	: device(device), completedSerial(std::make_shared<std::atomic<uint64_t>>(0)) {
+}
+
+uint64_t CompletionTracker::signal() {
+
+	auto serial = ++nextSerial;
+
+	struct PendingSerial {
+		std::shared_ptr<std::atomic<uint64_t>> completedSerial;
+		uint64_t serial;
+	};
+
+	device.GetQueue().OnSubmittedWorkDone(
+		[](WGPUQueueWorkDoneStatus, void* userdata) {
+			// Also on device loss, so waiters never hang.
+			auto pending = (PendingSerial*)userdata;
+			auto& completed = *pending->completedSerial;
+			auto current = completed.load(std::memory_order_relaxed);
+			while (current < pending->serial &&
+				   !completed.compare_exchange_weak(current, pending->serial, std::memory_order_release)) {
+			}
+			delete pending;
+		},
+		new PendingSerial{completedSerial, serial});
+
+	return serial;
+}
+
+bool CompletionTracker::isComplete(uint64_t serial) const {
+	return completedSerial->load(std::memory_order_acquire) >= serial;
+}
+
+bool CompletionTracker::wait(uint64_t serial, XrDuration timeout) {
+
+	auto deadline = getTime() + timeout;
+
+	while (!isComplete(serial)) {
+		if (getTime() >= deadline) return false;
+		device.Tick();
+		std::this_thread::yield();
+	}
+
+	return true;
+}
+
+wgpu::TextureUsage getSwapchainTextureUsage(XrSwapchainUsageFlags usageFlags) {
+
+	auto usage = wgpu::TextureUsage::None;
+
+	if (usageFlags & (XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT | XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT)) {
+		usage |= wgpu::TextureUsage::RenderAttachment;
+	}
+	if (usageFlags & (XR_SWAPCHAIN_USAGE_SAMPLED_BIT | XR_SWAPCHAIN_USAGE_INPUT_ATTACHMENT_BIT_KHR)) {
+		usage |= wgpu::TextureUsage::TextureBinding;
+	}
+	if (usageFlags & XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT) usage |= wgpu::TextureUsage::StorageBinding;
+	if (usageFlags & XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT) usage |= wgpu::TextureUsage::CopySrc;
+	if (usageFlags & XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT) usage |= wgpu::TextureUsage::CopyDst;
+
+	return usage;
+}
+
+bool isSwapchainFormatSupported(const wgpu::Device& device, wgpu::TextureFormat format) {
+
+	if (format == wgpu::TextureFormat::Depth32FloatStencil8) {
+		return device.HasFeature(wgpu::FeatureName::Depth32FloatStencil8);
+	}
+	return true;
+}
+
+} // namespace dawnxr::internal
+
+// Handles that aren't dawnxr's just fall through to the loader, which dispatches them by handle.
+
 namespace dawnxr {
 
 XrResult getGraphicsRequirements(XrInstance instance, XrSystemId systemId, wgpu::BackendType backendType,
 								 GraphicsRequirementsDawn* requirements) {
 
+	XR_TIMER("getGraphicsRequirements");
+
 	if (requirements->type != XR_TYPE_GRAPHICS_REQUIREMENTS_DAWN_EXT) return XR_ERROR_HANDLE_INVALID;
 
+	auto dawnInstance = getInstance(instance);
+
 	switch (backendType) {
 #ifdef XR_USE_GRAPHICS_API_D3D12
 	case wgpu::BackendType::D3D12:
-		XR_TRY(getD3D12GraphicsRequirements(instance, systemId, requirements));
+		XR_TRY(dawnInstance->checkLost(getD3D12GraphicsRequirements(dawnInstance, systemId, requirements)));
 		break;
 #endif
 #ifdef XR_USE_GRAPHICS_API_VULKAN
 	case wgpu::BackendType::Vulkan:
-		XR_TRY(getVulkanGraphicsRequirements(instance, systemId, requirements));
+		XR_TRY(dawnInstance->checkLost(getVulkanGraphicsRequirements(dawnInstance, systemId, requirements)));
 		break;
 #endif
 	default:
@@ -48,15 +538,19 @@ XrResult getGraphicsRequirements(XrInstance instance, XrSystemId systemId, wgpu:
 XrResult createRequestAdapterOptions(XrInstance instance, XrSystemId systemId, wgpu::BackendType backendType,
 									 wgpu::ChainedStruct** opts) {
 
+	XR_TIMER("createRequestAdapterOptions");
+
+	auto dawnInstance = getInstance(instance);
+
 	switch (backendType) {
 #ifdef XR_USE_GRAPHICS_API_D3D12
 	case wgpu::BackendType::D3D12:
-		XR_TRY(createD3D12RequestAdapterOptions(instance, systemId, opts));
+		XR_TRY(dawnInstance->checkLost(createD3D12RequestAdapterOptions(dawnInstance, systemId, opts)));
 		break;
 #endif
 #ifdef XR_USE_GRAPHICS_API_VULKAN
 	case wgpu::BackendType::Vulkan:
-		XR_TRY(createVulkanRequestAdapterOptions(instance, systemId, opts));
+		XR_TRY(dawnInstance->checkLost(createVulkanRequestAdapterOptions(dawnInstance, systemId, opts)));
 		break;
 #endif
 	default:
@@ -67,29 +561,53 @@ XrResult createRequestAdapterOptions(XrInstance instance, XrSystemId systemId, w
 	return XR_SUCCESS;
 }
 
+XrResult destroyInstance(XrInstance instance) {
+
+	XR_TIMER("destroyInstance");
+
+	releaseInstance(instance);
+
+	return XR_RUNTIME(xrDestroyInstance(instance));
+}
+
 XrResult createSession(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session) {
 
+	XR_TIMER("createSession");
+
 	auto binding = (GraphicsBindingDawn*)createInfo->next;
-	if (binding->type != XR_TYPE_GRAPHICS_BINDING_DAWN_EXT) return xrCreateSession(instance, createInfo, session);
+	if (binding->type != XR_TYPE_GRAPHICS_BINDING_DAWN_EXT) {
+		return XR_RUNTIME(getInstance(instance)->xrCreateSession(instance, createInfo, session));
+	}
 
 	auto backendType = (wgpu::BackendType)dawn::native::GetWGPUBackendType(dawn::native::GetWGPUAdapter(binding->device.Get()));
 
+	Session* dawnSession;
+
+	if (backendType == wgpu::BackendType::Null ||
+		findNext<HeadlessSessionCreateInfoDawn>(binding->next, XR_TYPE_HEADLESS_SESSION_CREATE_INFO_DAWN_EXT)) {
+		XR_TRY(createHeadlessSession(createInfo, &dawnSession));
+		*session = dawnSession->backendSession;
+		g_sessions.insert(*session, dawnSession);
+		return XR_SUCCESS;
+	}
+
 	// TODO: Woah, you *HAVE* to get graphics requirements or session creation fails?!?
+	// They're cached per system though, so this only hits the runtime once per instance.
 	//
 	GraphicsRequirementsDawn requirements{XR_TYPE_GRAPHICS_REQUIREMENTS_DAWN_EXT};
 	XR_TRY(getGraphicsRequirements(instance, createInfo->systemId, backendType, &requirements));
 
-	Session* dawnSession;
+	auto dawnInstance = getInstance(instance);
 
 	switch (backendType) {
 #ifdef XR_USE_GRAPHICS_API_D3D12
 	case wgpu::BackendType::D3D12:
-		XR_TRY(createD3D12Session(instance, createInfo, &dawnSession));
+		XR_TRY(dawnInstance->checkLost(createD3D12Session(dawnInstance, createInfo, &dawnSession)));
 		break;
 #endif
 #ifdef XR_USE_GRAPHICS_API_VULKAN
 	case wgpu::BackendType::Vulkan:
-		XR_TRY(createVulkanSession(instance, createInfo, &dawnSession));
+		XR_TRY(dawnInstance->checkLost(createVulkanSession(dawnInstance, createInfo, &dawnSession)));
 		break;
 #endif
 	default:
@@ -97,30 +615,99 @@ XrResult createSession(XrInstance instance, const XrSessionCreateInfo* createInf
 	}
 
 	*session = dawnSession->backendSession;
-	g_sessions.insert(std::make_pair(*session, dawnSession));
+	g_sessions.insert(*session, dawnSession);
 
 	return XR_SUCCESS;
 }
 
 XrResult destroySession(XrSession session) {
 
-	// TODO: What happens if a session is delete before its swapchains
-	auto it = g_sessions.find(session);
-	if (it != g_sessions.end()) {
-		delete it->second;
-		g_sessions.erase(it);
+	XR_TIMER("destroySession");
+
+	cancelAsyncSwapchains(session);
+
+	std::unique_ptr<Session> dawnSession(g_sessions.erase(session));
+	if (!dawnSession) return XR_RUNTIME(xrDestroySession(session));
+
+	trimSwapchainPool(dawnSession.get(), 0);
+	{
+		std::lock_guard<std::mutex> lock(g_msaaMutex);
+		g_msaaTargets.erase(dawnSession.get());
 	}
-	return xrDestroySession(session);
+
+	// Destroying a session destroys its swapchains, so clean up ours first.
+	std::vector<XrSwapchain> swapchains;
+	g_swapchains.forEach([&](XrSwapchain swapchain, Swapchain* dawnSwapchain) {
+		if (dawnSwapchain->session == dawnSession.get()) swapchains.push_back(swapchain);
+	});
+	for (auto swapchain : swapchains) destroySwapchain(swapchain);
+
+	return dawnSession->destroySession();
+}
+
+XrResult beginSession(XrSession session, const XrSessionBeginInfo* beginInfo) {
+
+	XR_TIMER("beginSession");
+
+	auto dawnSession = g_sessions.find(session);
+	if (!dawnSession) return XR_RUNTIME(xrBeginSession(session, beginInfo));
+
+	return dawnSession->beginSession(beginInfo);
+}
+
+XrResult endSession(XrSession session) {
+
+	XR_TIMER("endSession");
+
+	auto dawnSession = g_sessions.find(session);
+	if (!dawnSession) return XR_RUNTIME(xrEndSession(session));
+
+	return dawnSession->endSession();
+}
+
+XrResult waitFrame(XrSession session, const XrFrameWaitInfo* waitInfo, XrFrameState* frameState) {
+
+	XR_TIMER("waitFrame");
+
+	auto dawnSession = g_sessions.find(session);
+	if (!dawnSession) return XR_RUNTIME(xrWaitFrame(session, waitInfo, frameState));
+
+	return dawnSession->waitFrame(waitInfo, frameState);
+}
+
+XrResult beginFrame(XrSession session, const XrFrameBeginInfo* beginInfo) {
+
+	XR_TIMER("beginFrame");
+
+	auto dawnSession = g_sessions.find(session);
+	if (!dawnSession) return XR_RUNTIME(xrBeginFrame(session, beginInfo));
+
+	return dawnSession->beginFrame(beginInfo);
+}
+
+XrResult endFrame(XrSession session, const XrFrameEndInfo* endInfo) {
+
+	XrResult r;
+	{
+		XR_TIMER("endFrame");
+
+		auto dawnSession = g_sessions.find(session);
+		r = dawnSession ? dawnSession->endFrame(endInfo) : XR_RUNTIME(xrEndFrame(session, endInfo));
+	}
+	if (g_timingEnabled.load(std::memory_order_relaxed)) endTimingFrame();
+
+	return r;
 }
 
 XrResult enumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInput, uint32_t* formatCountOutput,
 								   int64_t* formats) {
 
-	auto it = g_sessions.find(session);
-	if (it == g_sessions.end()) { //
-		return xrEnumerateSwapchainFormats(session, formatCapacityInput, formatCountOutput, formats);
+	XR_TIMER("enumerateSwapchainFormats");
+
+	auto dawnSession = g_sessions.find(session);
+	if (!dawnSession) { //
+		return XR_RUNTIME(xrEnumerateSwapchainFormats(session, formatCapacityInput, formatCountOutput, formats));
 	}
-	auto dawnSession = it->second;
 
 	std::vector<wgpu::TextureFormat> dawnFormats;
 	XR_TRY(dawnSession->enumerateSwapchainFormats(dawnFormats));
@@ -137,42 +724,401 @@ XrResult enumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInp
 
 XrResult createSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo, XrSwapchain* swapchain) {
 
-	auto it = g_sessions.find(session);
-	if (it == g_sessions.end()) return xrCreateSwapchain(session, createInfo, swapchain);
-	auto dawnSession = it->second;
+	XR_TIMER("createSwapchain");
+
+	auto dawnSession = g_sessions.find(session);
+	if (!dawnSession) return XR_RUNTIME(xrCreateSwapchain(session, createInfo, swapchain));
+
+	// The MSAA create info is ours, so strip it before the backend sees it.
+	auto backendInfo = *createInfo;
+	uint32_t msaaSampleCount = 1;
+
+	auto msaaInfo = (const SwapchainMsaaCreateInfoDawn*)createInfo->next;
+	if (msaaInfo && msaaInfo->type == XR_TYPE_SWAPCHAIN_MSAA_CREATE_INFO_DAWN_EXT) {
+		// WebGPU only does 4x MSAA, and can only resolve single mip color targets.
+		if (msaaInfo->sampleCount != 4 || createInfo->sampleCount != 1 || createInfo->mipCount != 1 ||
+			createInfo->faceCount != 1 || !(createInfo->usageFlags & XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT)) {
+			return XR_ERROR_VALIDATION_FAILURE;
+		}
+		if (!isMultisampleSupported(dawnSession->device, (wgpu::TextureFormat)createInfo->format)) {
+			return XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+		}
+		msaaSampleCount = msaaInfo->sampleCount;
+		backendInfo.next = msaaInfo->next;
+	}
+
+	// Dawn can't use depth textures as color attachments and vice versa.
+	if (isDepthFormat((wgpu::TextureFormat)createInfo->format)) {
+		if (createInfo->usageFlags & (XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT | XR_SWAPCHAIN_USAGE_UNORDERED_ACCESS_BIT)) {
+			return XR_ERROR_VALIDATION_FAILURE;
+		}
+	} else if (createInfo->usageFlags & XR_SWAPCHAIN_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT) {
+		return XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	// Only plain create infos are pooled, we can't compare arbitrary next chains.
+	if (backendInfo.type == XR_TYPE_SWAPCHAIN_CREATE_INFO && !backendInfo.next) {
+		if (auto dawnSwapchain = takePooledSwapchain(dawnSession, backendInfo, msaaSampleCount)) {
+			*swapchain = dawnSwapchain->backendSwapchain;
+			g_swapchains.insert(*swapchain, dawnSwapchain.release());
+			return XR_SUCCESS;
+		}
+	}
 
 	std::vector<wgpu::Texture> images;
-	XR_TRY(dawnSession->createSwapchain(createInfo, images, swapchain));
+	XR_TRY(dawnSession->createSwapchain(&backendInfo, images, swapchain));
+
+	// After the runtime has validated the size, as the MSAA target can't fail synchronously.
+	std::shared_ptr<MsaaTarget> msaaTarget;
+	if (msaaSampleCount > 1) msaaTarget = getMsaaTarget(dawnSession, backendInfo, msaaSampleCount);
+
+	auto memoryUsage = estimateImageMemory(&backendInfo, images.size());
+	dawnSession->memoryUsage += memoryUsage;
+
+	auto poolingKey = backendInfo;
+	poolingKey.next = nullptr;
+	if (backendInfo.next) poolingKey.type = XR_TYPE_UNKNOWN;
 
-	auto dawnSwapchain = new Swapchain{*swapchain, dawnSession, std::move(images)};
-	g_swapchains.insert(std::make_pair(*swapchain, dawnSwapchain));
+	auto dawnSwapchain = new Swapchain{*swapchain, dawnSession, poolingKey, msaaTarget,
+									   createImageViews(images, msaaTarget.get()), memoryUsage,
+									   std::make_unique<std::atomic<uint64_t>[]>(images.size())};
+	g_swapchains.insert(*swapchain, dawnSwapchain);
 
 	return XR_SUCCESS;
 }
 
 XrResult destroySwapchain(XrSwapchain swapchain) {
 
-	auto it = g_swapchains.find(swapchain);
-	if (it != g_swapchains.end()) {
-		auto dawnSwapchain = it->second;
-		// TODO: Need to destroy swapchain image wrappers
-		// dawnSwapchain->session->destroySwapchainImages();
-		g_swapchains.erase(it);
-		delete dawnSwapchain;
+	XR_TIMER("destroySwapchain");
+
+	std::unique_ptr<Swapchain> dawnSwapchain(g_swapchains.erase(swapchain));
+	if (!dawnSwapchain) return XR_RUNTIME(xrDestroySwapchain(swapchain));
+
+	// Static images can only be acquired once, and images still acquired can't be acquired again until released.
+	if (dawnSwapchain->createInfo.type == XR_TYPE_SWAPCHAIN_CREATE_INFO &&
+		!(dawnSwapchain->createInfo.createFlags & XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT) &&
+		dawnSwapchain->acquiredImages.empty()) {
+		std::unique_ptr<Swapchain> evicted;
+		{
+			std::lock_guard<std::mutex> lock(g_poolsMutex);
+
+			auto it = g_pools.find(dawnSwapchain->session);
+			if (it != g_pools.end()) {
+				auto& pool = it->second;
+				dawnSwapchain->dynamicResolution.reset();
+				dawnSwapchain->generateMips = false;
+				dawnSwapchain->upload.reset();
+				dawnSwapchain->readback.reset();
+				dawnSwapchain->mirror.reset();
+				pool.swapchains.push_back(std::move(dawnSwapchain));
+				if (pool.swapchains.size() > pool.capacity) {
+					evicted = std::move(pool.swapchains.front());
+					pool.swapchains.erase(pool.swapchains.begin());
+				}
+			}
+		}
+		if (evicted) return destroyBackendSwapchain(std::move(evicted));
+		if (!dawnSwapchain) return XR_SUCCESS;
+	}
+
+	return destroyBackendSwapchain(std::move(dawnSwapchain));
+}
+
+XrResult setSwapchainPoolSize(XrSession session, uint32_t poolSize) {
+
+	XR_TIMER("setSwapchainPoolSize");
+
+	auto dawnSession = g_sessions.find(session);
+	if (!dawnSession) return XR_ERROR_HANDLE_INVALID;
+
+	if (poolSize) {
+		std::lock_guard<std::mutex> lock(g_poolsMutex);
+		g_pools[dawnSession].capacity = poolSize;
+	}
+	trimSwapchainPool(dawnSession, poolSize);
+
+	return XR_SUCCESS;
+}
+
+XrResult chainDepthInfos(XrSwapchain depthSwapchain, float nearZ, float farZ, uint32_t viewCount,
+						 XrCompositionLayerProjectionView* views, XrCompositionLayerDepthInfoKHR* depthInfos) {
+
+	auto dawnSwapchain = g_swapchains.find(depthSwapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	auto& createInfo = dawnSwapchain->createInfo;
+	if (!isDepthFormat((wgpu::TextureFormat)createInfo.format)) return XR_ERROR_VALIDATION_FAILURE;
+
+	for (auto i = 0u; i < viewCount; ++i) {
+		auto& view = views[i];
+		auto& depthInfo = depthInfos[i];
+
+		depthInfo = {XR_TYPE_COMPOSITION_LAYER_DEPTH_INFO_KHR};
+		depthInfo.subImage.swapchain = depthSwapchain;
+		depthInfo.subImage.imageRect = view.subImage.imageRect;
+		// One layer per view if the depth swapchain is layered, else follow the color image.
+		depthInfo.subImage.imageArrayIndex = createInfo.arraySize > 1 ? i : view.subImage.imageArrayIndex;
+		depthInfo.minDepth = 0;
+		depthInfo.maxDepth = 1;
+		depthInfo.nearZ = nearZ;
+		depthInfo.farZ = farZ;
+
+		depthInfo.next = view.next;
+		view.next = &depthInfo;
+	}
+
+	return XR_SUCCESS;
+}
+
+XrResult setMipGenerationEnabled(XrSwapchain swapchain, bool enabled) {
+
+	XR_TIMER("setMipGenerationEnabled");
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (enabled && dawnSwapchain->mipPasses.empty()) {
+		auto& createInfo = dawnSwapchain->createInfo;
+		auto requiredUsage = XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT | XR_SWAPCHAIN_USAGE_SAMPLED_BIT;
+		if (createInfo.mipCount < 2 || (createInfo.usageFlags & requiredUsage) != requiredUsage ||
+			!Blitter::isBlittable((wgpu::TextureFormat)createInfo.format)) {
+			return XR_ERROR_VALIDATION_FAILURE;
+		}
+
+		auto& blitter = dawnSwapchain->session->getBlitter();
+		for (auto& image : dawnSwapchain->images) {
+			dawnSwapchain->mipPasses.push_back(blitter.createMipPasses(image.texture));
+		}
+	}
+	dawnSwapchain->generateMips = enabled;
+
+	return XR_SUCCESS;
+}
+
+XrResult enableUpload(XrSwapchain swapchain, const UploadInfoDawn* info) {
+
+	XR_TIMER("enableUpload");
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	dawnSwapchain->upload.reset();
+	if (!info) return XR_SUCCESS;
+
+	auto& createInfo = dawnSwapchain->createInfo;
+	if (!info->bufferCount || info->arrayLayer >= createInfo.arraySize || createInfo.sampleCount != 1 ||
+		!(createInfo.usageFlags & XR_SWAPCHAIN_USAGE_TRANSFER_DST_BIT) ||
+		isDepthFormat((wgpu::TextureFormat)createInfo.format)) {
+		return XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	dawnSwapchain->upload = std::make_unique<Upload>(dawnSwapchain->session, createInfo, dawnSwapchain->images, *info);
+
+	return XR_SUCCESS;
+}
+
+XrResult beginUpload(XrSwapchain swapchain, XrDuration timeout, UploadBufferDawn* buffer) {
+
+	XR_TIMER("beginUpload");
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (!dawnSwapchain->upload) return XR_ERROR_CALL_ORDER_INVALID;
+
+	return dawnSwapchain->upload->begin(timeout, buffer);
+}
+
+XrResult endUpload(XrSwapchain swapchain, const UploadBufferDawn* buffer) {
+
+	XR_TIMER("endUpload");
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (!dawnSwapchain->upload) return XR_ERROR_CALL_ORDER_INVALID;
+
+	return dawnSwapchain->upload->end(buffer);
+}
+
+XrResult getUploadStats(XrSwapchain swapchain, UploadStatsDawn* stats) {
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (!dawnSwapchain->upload) return XR_ERROR_CALL_ORDER_INVALID;
+
+	dawnSwapchain->upload->getStats(stats);
+
+	return XR_SUCCESS;
+}
+
+XrResult enableReadback(XrSwapchain swapchain, const ReadbackInfoDawn* info) {
+
+	XR_TIMER("enableReadback");
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	dawnSwapchain->readback.reset();
+	if (!info) return XR_SUCCESS;
+
+	auto& createInfo = dawnSwapchain->createInfo;
+	if (!info->callback || !info->bufferCount || !info->downscale || info->arrayLayer >= createInfo.arraySize ||
+		createInfo.sampleCount != 1 || isDepthFormat((wgpu::TextureFormat)createInfo.format)) {
+		return XR_ERROR_VALIDATION_FAILURE;
+	}
+	if (info->downscale > 1) {
+		if (!(createInfo.usageFlags & XR_SWAPCHAIN_USAGE_SAMPLED_BIT) ||
+			!Blitter::isBlittable((wgpu::TextureFormat)createInfo.format)) {
+			return XR_ERROR_VALIDATION_FAILURE;
+		}
+	} else if (!(createInfo.usageFlags & XR_SWAPCHAIN_USAGE_TRANSFER_SRC_BIT)) {
+		return XR_ERROR_VALIDATION_FAILURE;
 	}
 
-	return xrDestroySwapchain(swapchain);
+	dawnSwapchain->readback =
+		std::make_unique<Readback>(dawnSwapchain->session, createInfo, dawnSwapchain->images, *info);
+
+	return XR_SUCCESS;
+}
+
+XrResult getReadbackStats(XrSwapchain swapchain, ReadbackStatsDawn* stats) {
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (!dawnSwapchain->readback) return XR_ERROR_CALL_ORDER_INVALID;
+
+	dawnSwapchain->readback->getStats(stats);
+
+	return XR_SUCCESS;
+}
+
+XrResult enableMirror(XrSwapchain swapchain, const MirrorInfoDawn* info) {
+
+	XR_TIMER("enableMirror");
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	dawnSwapchain->mirror.reset();
+	if (!info) return XR_SUCCESS;
+
+	auto& createInfo = dawnSwapchain->createInfo;
+	if (!info->surface || !info->width || !info->height || info->arrayLayer >= createInfo.arraySize ||
+		createInfo.sampleCount != 1 || !(createInfo.usageFlags & XR_SWAPCHAIN_USAGE_SAMPLED_BIT) ||
+		!Blitter::isBlittable((wgpu::TextureFormat)createInfo.format) || !Blitter::isBlittable(info->format) ||
+		!Mirror::isNonBlocking(info->presentMode)) {
+		return XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	if (!Mirror::isSupported(dawnSwapchain->session->device, *info)) return XR_ERROR_FEATURE_UNSUPPORTED;
+
+	dawnSwapchain->mirror =
+		std::make_unique<Mirror>(dawnSwapchain->session, createInfo, dawnSwapchain->images, *info);
+
+	return XR_SUCCESS;
+}
+
+XrResult getMirrorStats(XrSwapchain swapchain, MirrorStatsDawn* stats) {
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (!dawnSwapchain->mirror) return XR_ERROR_CALL_ORDER_INVALID;
+
+	dawnSwapchain->mirror->getStats(stats);
+
+	return XR_SUCCESS;
+}
+
+XrResult enableDynamicResolution(XrSwapchain swapchain, const DynamicResolutionInfoDawn* info) {
+
+	XR_TIMER("enableDynamicResolution");
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (!info) {
+		dawnSwapchain->dynamicResolution.reset();
+		return XR_SUCCESS;
+	}
+
+	if (info->targetGpuTime <= 0 || info->minScale <= 0 || info->minScale > info->maxScale || info->maxScale > 1) {
+		return XR_ERROR_VALIDATION_FAILURE;
+	}
+
+	dawnSwapchain->dynamicResolution.emplace(
+		DynamicResolution{info->targetGpuTime, info->minScale, info->maxScale, info->maxScale});
+
+	return XR_SUCCESS;
+}
+
+XrResult updateDynamicResolution(XrSwapchain swapchain, XrDuration gpuTime) {
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (!dawnSwapchain->dynamicResolution) return XR_ERROR_CALL_ORDER_INVALID;
+	if (gpuTime <= 0) return XR_ERROR_VALIDATION_FAILURE;
+
+	updateDynamicResolution(*dawnSwapchain->dynamicResolution, gpuTime);
+
+	return XR_SUCCESS;
+}
+
+XrResult getDynamicResolutionRect(XrSwapchain swapchain, XrRect2Di* imageRect) {
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	*imageRect = getImageRect(*dawnSwapchain);
+
+	return XR_SUCCESS;
+}
+
+XrResult getSessionMemoryUsage(XrSession session, uint64_t* bytes) {
+
+	auto dawnSession = g_sessions.find(session);
+	if (!dawnSession) return XR_ERROR_HANDLE_INVALID;
+
+	*bytes = dawnSession->memoryUsage;
+
+	return XR_SUCCESS;
+}
+
+XrResult getSessionSubmitCount(XrSession session, uint64_t* submitCount) {
+
+	auto dawnSession = g_sessions.find(session);
+	if (!dawnSession) return XR_ERROR_HANDLE_INVALID;
+
+	*submitCount = dawnSession->submitCount;
+
+	return XR_SUCCESS;
+}
+
+XrResult getSwapchainMemoryUsage(XrSwapchain swapchain, uint64_t* bytes) {
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	*bytes = dawnSwapchain->memoryUsage;
+	if (dawnSwapchain->upload) *bytes += dawnSwapchain->upload->getMemoryUsage();
+	if (dawnSwapchain->readback) *bytes += dawnSwapchain->readback->getMemoryUsage();
+
+	return XR_SUCCESS;
 }
 
 XrResult enumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityInput, uint32_t* imageCountOutput,
 								  XrSwapchainImageBaseHeader* images) {
 
-	auto it = g_swapchains.find(swapchain);
-	if (it == g_swapchains.end()) { //
-		return xrEnumerateSwapchainImages(swapchain, imageCapacityInput, imageCountOutput, images);
-	}
+	XR_TIMER("enumerateSwapchainImages");
 
-	auto dawnSwapchain = it->second;
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) { //
+		return XR_RUNTIME(xrEnumerateSwapchainImages(swapchain, imageCapacityInput, imageCountOutput, images));
+	}
 
 	*imageCountOutput = (uint32_t)dawnSwapchain->images.size();
 
@@ -181,11 +1127,178 @@ XrResult enumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityI
 		auto dawnImages = (SwapchainImageDawn*)images;
 		for (auto i = 0u; i < n; ++i) {
 			if (dawnImages[i].type != XR_TYPE_SWAPCHAIN_IMAGE_DAWN_EXT) return XR_ERROR_HANDLE_INVALID;
-			dawnImages[i].texture = dawnSwapchain->images[i];
+			dawnImages[i].texture = dawnSwapchain->images[i].texture;
 		}
 	}
 
 	return XR_SUCCESS;
 }
 
+XrResult acquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo, uint32_t* index) {
+
+	XR_TIMER("acquireSwapchainImage");
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_RUNTIME(xrAcquireSwapchainImage(swapchain, acquireInfo, index));
+
+	XR_TRY(dawnSwapchain->session->acquireSwapchainImage(swapchain, acquireInfo, index));
+	if (*index >= dawnSwapchain->images.size()) return XR_ERROR_RUNTIME_FAILURE;
+
+	dawnSwapchain->acquiredImages.push_back(*index);
+
+	return XR_SUCCESS;
+}
+
+XrResult acquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo, uint32_t* index,
+							   const SwapchainImageViewsDawn** image) {
+
+	XR_TIMER("acquireSwapchainImage");
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	XR_TRY(dawnSwapchain->session->acquireSwapchainImage(swapchain, acquireInfo, index));
+	if (*index >= dawnSwapchain->images.size()) return XR_ERROR_RUNTIME_FAILURE;
+
+	dawnSwapchain->acquiredImages.push_back(*index);
+	*image = &dawnSwapchain->images[*index];
+
+	return XR_SUCCESS;
+}
+
+XrResult isSwapchainImageIdle(XrSwapchain swapchain, uint32_t index, XrBool32* idle) {
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (index >= dawnSwapchain->images.size()) return XR_ERROR_VALIDATION_FAILURE;
+
+	auto serial = dawnSwapchain->releaseSerials[index].load(std::memory_order_acquire);
+	*idle = dawnSwapchain->session->completion.isComplete(serial) ? XR_TRUE : XR_FALSE;
+
+	return XR_SUCCESS;
+}
+
+XrResult waitSwapchainImageIdle(XrSwapchain swapchain, uint32_t index, XrDuration timeout) {
+
+	XR_TIMER("waitSwapchainImageIdle");
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (index >= dawnSwapchain->images.size()) return XR_ERROR_VALIDATION_FAILURE;
+
+	auto serial = dawnSwapchain->releaseSerials[index].load(std::memory_order_acquire);
+
+	return dawnSwapchain->session->completion.wait(serial, timeout) ? XR_SUCCESS : XR_TIMEOUT_EXPIRED;
+}
+
+XrResult waitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo) {
+
+	XR_TIMER("waitSwapchainImage");
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_RUNTIME(xrWaitSwapchainImage(swapchain, waitInfo));
+
+	XR_TRY(dawnSwapchain->session->waitSwapchainImage(swapchain, waitInfo));
+
+	auto& dynamicResolution = dawnSwapchain->dynamicResolution;
+
+	if (isGpuTimed(*dawnSwapchain)) {
+		auto session = dawnSwapchain->session;
+		auto& device = session->device;
+		if (!dawnSwapchain->gpuTimer && GpuTimer::isSupported(device)) {
+			dawnSwapchain->gpuTimer = std::make_unique<GpuTimer>(device);
+		}
+		if (auto gpuTimer = dawnSwapchain->gpuTimer.get()) {
+			// Readbacks land a few frames late, just use the latest one.
+			auto gpuTime = gpuTimer->lastDuration->exchange(0, std::memory_order_acq_rel);
+			if (gpuTime && dynamicResolution) updateDynamicResolution(*dynamicResolution, gpuTime);
+
+			// The last release wrote a begin timestamp at the end of its submit. If the GPU is still busy with that,
+			// the app's work queues up right behind it, so it's where this image's work starts. Otherwise the GPU
+			// could idle in between, so begin again in a submit of our own.
+			auto& completion = session->completion;
+			auto busy = gpuTimer->begun && !completion.isComplete(gpuTimer->beginSerial);
+			if (busy) {
+				device.Tick();
+				busy = !completion.isComplete(gpuTimer->beginSerial);
+			}
+			if (!busy) {
+				CommandBatch batch(session);
+				gpuTimer->begin(batch);
+				batch.submit();
+			}
+		}
+	}
+
+	return XR_SUCCESS;
+}
+
+XrResult releaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo) {
+
+	XR_TIMER("releaseSwapchainImage");
+
+	auto dawnSwapchain = g_swapchains.find(swapchain);
+	if (!dawnSwapchain) return XR_RUNTIME(xrReleaseSwapchainImage(swapchain, releaseInfo));
+
+	// Images are released in the order they were acquired.
+	auto& acquiredImages = dawnSwapchain->acquiredImages;
+	if (acquiredImages.empty()) return XR_ERROR_CALL_ORDER_INVALID;
+	auto index = acquiredImages.front();
+	acquiredImages.erase(acquiredImages.begin());
+
+	auto session = dawnSwapchain->session;
+	auto& image = dawnSwapchain->images[index];
+
+	// All our work on the image goes in one batch, submitted before the runtime gets the image back.
+	CommandBatch batch(session);
+	bool touched = false;
+
+	// Uploads go first, so the mips, readback and mirror see the new image.
+	if (dawnSwapchain->upload && dawnSwapchain->upload->encode(batch, index)) touched = true;
+
+	if (dawnSwapchain->generateMips) {
+		auto& blitter = session->getBlitter();
+		for (auto& pass : dawnSwapchain->mipPasses[index]) blitter.encode(batch.get(), pass);
+		touched = true;
+	}
+
+	// The rect the app rendered this frame, as the scale only changes in waitSwapchainImage or when the app changes it.
+	auto rect = getImageRect(*dawnSwapchain);
+
+	if (dawnSwapchain->readback && dawnSwapchain->readback->capture(batch, index, rect)) touched = true;
+
+	if (dawnSwapchain->mirror && dawnSwapchain->mirror->encode(batch, index, rect)) touched = true;
+
+	// Dawn tracks image state implicitly and leaves it however we last used it, so finish with an empty render pass
+	// over everything we touched to get exactly one transition back to the attachment state the runtime expects.
+	if (touched && session->needsAttachmentOnRelease() &&
+		(dawnSwapchain->createInfo.usageFlags & XR_SWAPCHAIN_USAGE_COLOR_ATTACHMENT_BIT)) {
+		for (auto& view : image.layerViews) encodeLoadStorePass(batch.get(), view);
+		if (dawnSwapchain->generateMips) {
+			for (auto& pass : dawnSwapchain->mipPasses[index]) encodeLoadStorePass(batch.get(), pass.target);
+		}
+	}
+
+	if (dawnSwapchain->gpuTimer) {
+		dawnSwapchain->gpuTimer->end(batch);
+		if (isGpuTimed(*dawnSwapchain)) dawnSwapchain->gpuTimer->beginNext(batch);
+	}
+
+	if (batch.submit()) {
+		if (dawnSwapchain->upload) dawnSwapchain->upload->submitted();
+		if (dawnSwapchain->readback) dawnSwapchain->readback->submitted();
+		if (dawnSwapchain->mirror) dawnSwapchain->mirror->submitted();
+		if (dawnSwapchain->gpuTimer) dawnSwapchain->gpuTimer->submitted();
+	}
+
+	// Covers the app's work on the image too, as it has to be submitted before the release.
+	auto serial = session->completion.signal();
+	dawnSwapchain->releaseSerials[index].store(serial, std::memory_order_release);
+	if (dawnSwapchain->gpuTimer) dawnSwapchain->gpuTimer->beginSerial = serial;
+
+	return session->releaseSwapchainImage(swapchain, releaseInfo);
+}
+
 } // namespace dawnxr
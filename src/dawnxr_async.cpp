@@ -0,0 +1,132 @@
+#include "dawnxr_internal.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace dawnxr::internal;
+
+namespace {
+
+struct AsyncSwapchainJob {
+	XrSession session;
+	XrSwapchainCreateInfo createInfo;
+	std::function<void(XrResult, XrSwapchain)> callback;
+	bool cancelled = false; // Session was destroyed, complete without creating anything
+};
+
+// Runs createSwapchain jobs in call order on a single worker thread, started on first use.
+class AsyncSwapchainWorker {
+public:
+	~AsyncSwapchainWorker() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		cond.notify_all();
+		if (thread.joinable()) thread.join();
+	}
+
+	void push(AsyncSwapchainJob job) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!thread.joinable()) thread = std::thread([this] { run(); });
+			jobs.push_back(std::move(job));
+		}
+		cond.notify_all();
+	}
+
+	// Cancels queued jobs for a session and waits for any running one to finish creating its swapchain. Cancelled jobs
+	// stay queued so their callbacks still run on the worker, in call order.
+	void cancel(XrSession session) {
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		for (auto& job : jobs) {
+			if (job.session == session) job.cancelled = true;
+		}
+
+		cond.wait(lock, [this, session] { return running != session; });
+	}
+
+private:
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::deque<AsyncSwapchainJob> jobs;
+	XrSession running = XR_NULL_HANDLE; // Session of the job being created, callbacks run after this is cleared
+	bool stopping = false;
+	std::thread thread;
+
+	void run() {
+
+		std::unique_lock<std::mutex> lock(mutex);
+
+		for (;;) {
+			cond.wait(lock, [this] { return stopping || !jobs.empty(); });
+			if (stopping) return;
+
+			auto job = std::move(jobs.front());
+			jobs.pop_front();
+
+			if (job.cancelled) {
+				lock.unlock();
+				job.callback(XR_ERROR_HANDLE_INVALID, XR_NULL_HANDLE);
+				lock.lock();
+				continue;
+			}
+
+			running = job.session;
+			lock.unlock();
+
+			XrSwapchain swapchain = XR_NULL_HANDLE;
+			auto r = dawnxr::createSwapchain(job.session, &job.createInfo, &swapchain);
+
+			lock.lock();
+			running = XR_NULL_HANDLE;
+			cond.notify_all();
+			lock.unlock();
+
+			// Callbacks can destroy the session, or queue more work.
+			job.callback(r, swapchain);
+
+			lock.lock();
+		}
+	}
+};
+
+AsyncSwapchainWorker g_asyncSwapchainWorker;
+
+} // namespace
+
+namespace dawnxr::internal {
+
+void cancelAsyncSwapchains(XrSession session) {
+	g_asyncSwapchainWorker.cancel(session);
+}
+
+} // namespace dawnxr::internal
+
+namespace dawnxr {
+
+XrResult createSwapchainAsync(XrSession session, const XrSwapchainCreateInfo* createInfo,
+							  std::function<void(XrResult, XrSwapchain)> callback) {
+
+	XR_TIMER("createSwapchainAsync");
+
+	if (createInfo->type != XR_TYPE_SWAPCHAIN_CREATE_INFO || !callback) return XR_ERROR_VALIDATION_FAILURE;
+
+	auto dawnSession = findSession(session);
+	if (!dawnSession) return XR_ERROR_HANDLE_INVALID;
+
+	// The worker thread creates textures while the app is using the device.
+	if (!dawnSession->device.HasFeature(wgpu::FeatureName::ImplicitDeviceSynchronization)) {
+		return XR_ERROR_FEATURE_UNSUPPORTED;
+	}
+
+	g_asyncSwapchainWorker.push({session, *createInfo, std::move(callback)});
+
+	return XR_SUCCESS;
+}
+
+} // namespace dawnxr
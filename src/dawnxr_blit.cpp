@@ -0,0 +1,230 @@
+#include "dawnxr_internal.h"
+
+#include <cstring>
+
+namespace {
+
+constexpr char blitShader[] = R"(
+struct VertexOutput {
+	@builtin(position) position : vec4<f32>,
+	@location(0) uv : vec2<f32>,
+}
+
+@vertex fn vertexMain(@builtin(vertex_index) index : u32) -> VertexOutput {
+	// Fullscreen triangle.
+	let uv = vec2<f32>(f32((index << 1u) & 2u), f32(index & 2u));
+	var output : VertexOutput;
+	output.position = vec4<f32>(uv * vec2<f32>(2.0, -2.0) + vec2<f32>(-1.0, 1.0), 0.0, 1.0);
+	output.uv = uv;
+	return output;
+}
+
+@group(0) @binding(0) var sourceTexture : texture_2d<f32>;
+@group(0) @binding(1) var sourceSampler : sampler;
+
+struct SourceRect {
+	offset : vec2<f32>,
+	scale : vec2<f32>,
+}
+
+@group(0) @binding(2) var<uniform> sourceRect : SourceRect;
+
+@fragment fn fragmentMain(input : VertexOutput) -> @location(0) vec4<f32> {
+	// Clamped half a texel inside the rect, so filtering doesn't pull in texels from outside it.
+	let halfTexel = 0.5 / vec2<f32>(textureDimensions(sourceTexture));
+	let uv = clamp(sourceRect.offset + input.uv * sourceRect.scale, sourceRect.offset + halfTexel,
+				   sourceRect.offset + sourceRect.scale - halfTexel);
+	return textureSample(sourceTexture, sourceSampler, uv);
+}
+)";
+
+} // namespace
+
+namespace dawnxr::internal {
+
+Blitter::Blitter(const wgpu::Device& device) : device(device) {
+
+	wgpu::ShaderModuleWGSLDescriptor wgslDesc{};
+	wgslDesc.code = blitShader;
+	wgpu::ShaderModuleDescriptor shaderDesc{};
+	shaderDesc.nextInChain = &wgslDesc;
+	shaderModule = device.CreateShaderModule(&shaderDesc);
+
+	wgpu::SamplerDescriptor samplerDesc{};
+	samplerDesc.magFilter = wgpu::FilterMode::Linear;
+	samplerDesc.minFilter = wgpu::FilterMode::Linear;
+	sampler = device.CreateSampler(&samplerDesc);
+
+	wgpu::BindGroupLayoutEntry entries[3]{};
+	entries[0].binding = 0;
+	entries[0].visibility = wgpu::ShaderStage::Fragment;
+	entries[0].texture.sampleType = wgpu::TextureSampleType::Float;
+	entries[0].texture.viewDimension = wgpu::TextureViewDimension::e2D;
+	entries[1].binding = 1;
+	entries[1].visibility = wgpu::ShaderStage::Fragment;
+	entries[1].sampler.type = wgpu::SamplerBindingType::Filtering;
+	entries[2].binding = 2;
+	entries[2].visibility = wgpu::ShaderStage::Fragment;
+	entries[2].buffer.type = wgpu::BufferBindingType::Uniform;
+
+	wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc{};
+	bindGroupLayoutDesc.entryCount = 3;
+	bindGroupLayoutDesc.entries = entries;
+	bindGroupLayout = device.CreateBindGroupLayout(&bindGroupLayoutDesc);
+
+	wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+	pipelineLayoutDesc.bindGroupLayoutCount = 1;
+	pipelineLayoutDesc.bindGroupLayouts = &bindGroupLayout;
+	pipelineLayout = device.CreatePipelineLayout(&pipelineLayoutDesc);
+}
+
+bool Blitter::isBlittable(wgpu::TextureFormat format) {
+	switch (format) {
+	case wgpu::TextureFormat::BGRA8UnormSrgb:
+	case wgpu::TextureFormat::BGRA8Unorm:
+	case wgpu::TextureFormat::RGBA8UnormSrgb:
+	case wgpu::TextureFormat::RGBA8Unorm:
+	case wgpu::TextureFormat::RGBA16Float:
+	case wgpu::TextureFormat::RGB10A2Unorm:
+		return true;
+	default:
+		// RG11B10Ufloat is only renderable with an optional feature, and RGBA32Float only filterable with one.
+		return false;
+	}
+}
+
+Blitter::Source Blitter::createSource(const wgpu::TextureView& source) {
+
+	// Starts out sampling the whole view.
+	constexpr float wholeRect[4] = {0, 0, 1, 1};
+
+	wgpu::BufferDescriptor bufferDesc{};
+	bufferDesc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+	bufferDesc.size = sizeof(wholeRect);
+	bufferDesc.mappedAtCreation = true;
+	auto rectBuffer = device.CreateBuffer(&bufferDesc);
+	std::memcpy(rectBuffer.GetMappedRange(), wholeRect, sizeof(wholeRect));
+	rectBuffer.Unmap();
+
+	wgpu::BindGroupEntry entries[3]{};
+	entries[0].binding = 0;
+	entries[0].textureView = source;
+	entries[1].binding = 1;
+	entries[1].sampler = sampler;
+	entries[2].binding = 2;
+	entries[2].buffer = rectBuffer;
+	entries[2].size = sizeof(wholeRect);
+
+	wgpu::BindGroupDescriptor bindGroupDesc{};
+	bindGroupDesc.layout = bindGroupLayout;
+	bindGroupDesc.entryCount = 3;
+	bindGroupDesc.entries = entries;
+
+	return {device.CreateBindGroup(&bindGroupDesc), rectBuffer};
+}
+
+void Blitter::setSourceRect(Source& source, const XrRect2Di& rect, uint32_t width, uint32_t height) {
+
+	if (rect.offset.x == source.rect.offset.x && rect.offset.y == source.rect.offset.y &&
+		rect.extent.width == source.rect.extent.width && rect.extent.height == source.rect.extent.height) {
+		return;
+	}
+	source.rect = rect;
+
+	float uvRect[4] = {(float)rect.offset.x / width, (float)rect.offset.y / height, (float)rect.extent.width / width,
+					   (float)rect.extent.height / height};
+	device.GetQueue().WriteBuffer(source.rectBuffer, 0, uvRect, sizeof(uvRect));
+}
+
+Blitter::Pass Blitter::createPass(const wgpu::TextureView& source, const wgpu::TextureView& target,
+								  wgpu::TextureFormat format) {
+	return {createSource(source), target, format};
+}
+
+std::vector<Blitter::Pass> Blitter::createMipPasses(const wgpu::Texture& texture) {
+
+	std::vector<Pass> passes;
+
+	auto format = texture.GetFormat();
+
+	for (auto layer = 0u; layer < texture.GetDepthOrArrayLayers(); ++layer) {
+		for (auto mip = 1u; mip < texture.GetMipLevelCount(); ++mip) {
+			wgpu::TextureViewDescriptor viewDesc{};
+			viewDesc.dimension = wgpu::TextureViewDimension::e2D;
+			viewDesc.baseArrayLayer = layer;
+			viewDesc.arrayLayerCount = 1;
+			viewDesc.mipLevelCount = 1;
+
+			viewDesc.baseMipLevel = mip - 1;
+			auto source = texture.CreateView(&viewDesc);
+			viewDesc.baseMipLevel = mip;
+			auto target = texture.CreateView(&viewDesc);
+
+			passes.push_back(createPass(source, target, format));
+		}
+	}
+
+	return passes;
+}
+
+void Blitter::encode(const wgpu::CommandEncoder& encoder, const Pass& pass, const XrExtent2Di* targetExtent) {
+	encode(encoder, pass.source, pass.target, pass.format, targetExtent);
+}
+
+void Blitter::encode(const wgpu::CommandEncoder& encoder, const Source& source, const wgpu::TextureView& target,
+					 wgpu::TextureFormat format, const XrExtent2Di* targetExtent) {
+
+	wgpu::RenderPassColorAttachment colorAttachment{};
+	colorAttachment.view = target;
+	colorAttachment.loadOp = wgpu::LoadOp::Clear;
+	colorAttachment.storeOp = wgpu::StoreOp::Store;
+
+	wgpu::RenderPassDescriptor passDesc{};
+	passDesc.colorAttachmentCount = 1;
+	passDesc.colorAttachments = &colorAttachment;
+
+	auto renderPass = encoder.BeginRenderPass(&passDesc);
+	renderPass.SetPipeline(getPipeline(format));
+	renderPass.SetBindGroup(0, source.bindGroup);
+	if (targetExtent) {
+		renderPass.SetViewport(0, 0, (float)targetExtent->width, (float)targetExtent->height, 0, 1);
+	}
+	renderPass.Draw(3);
+	renderPass.End();
+}
+
+const wgpu::RenderPipeline& Blitter::getPipeline(wgpu::TextureFormat format) {
+
+	std::lock_guard<std::mutex> lock(pipelinesMutex);
+
+	auto& pipeline = pipelines[format];
+	if (pipeline) return pipeline;
+
+	wgpu::ColorTargetState colorTarget{};
+	colorTarget.format = format;
+
+	wgpu::FragmentState fragmentState{};
+	fragmentState.module = shaderModule;
+	fragmentState.entryPoint = "fragmentMain";
+	fragmentState.targetCount = 1;
+	fragmentState.targets = &colorTarget;
+
+	wgpu::RenderPipelineDescriptor pipelineDesc{};
+	pipelineDesc.layout = pipelineLayout;
+	pipelineDesc.vertex.module = shaderModule;
+	pipelineDesc.vertex.entryPoint = "vertexMain";
+	pipelineDesc.fragment = &fragmentState;
+
+	pipeline = device.CreateRenderPipeline(&pipelineDesc);
+
+	return pipeline;
+}
+
+Blitter& Session::getBlitter() {
+
+	std::call_once(blitterOnce, [this] { blitter = std::make_unique<Blitter>(device); });
+
+	return *blitter;
+}
+
+} // namespace dawnxr::internal
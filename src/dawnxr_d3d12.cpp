@@ -3,6 +3,7 @@
 #include <dawn/native/D3D12Backend.h>
 
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "d3dx/d3dx12_core.h"
@@ -11,17 +12,63 @@ using namespace dawnxr::internal;
 
 namespace {
 
-const auto dawnSwapchainFormat = wgpu::TextureFormat::BGRA8UnormSrgb;
-const auto d3d12SwapchainFormat = DXGI_FORMAT_B8G8R8A8_UNORM_SRGB;
+// Swapchain formats dawnxr can wrap. Enumeration order comes from the runtime, not this table.
+constexpr struct {
+	wgpu::TextureFormat dawnFormat;
+	DXGI_FORMAT d3d12Format;
+} swapchainFormats[] = {
+	{wgpu::TextureFormat::BGRA8UnormSrgb, DXGI_FORMAT_B8G8R8A8_UNORM_SRGB},
+	{wgpu::TextureFormat::BGRA8Unorm, DXGI_FORMAT_B8G8R8A8_UNORM},
+	{wgpu::TextureFormat::RGBA8UnormSrgb, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB},
+	{wgpu::TextureFormat::RGBA8Unorm, DXGI_FORMAT_R8G8B8A8_UNORM},
+	{wgpu::TextureFormat::RGBA16Float, DXGI_FORMAT_R16G16B16A16_FLOAT},
+	{wgpu::TextureFormat::RGB10A2Unorm, DXGI_FORMAT_R10G10B10A2_UNORM},
+	{wgpu::TextureFormat::RG11B10Ufloat, DXGI_FORMAT_R11G11B10_FLOAT},
+	{wgpu::TextureFormat::RGBA32Float, DXGI_FORMAT_R32G32B32A32_FLOAT},
+	{wgpu::TextureFormat::Depth16Unorm, DXGI_FORMAT_D16_UNORM},
+	{wgpu::TextureFormat::Depth32Float, DXGI_FORMAT_D32_FLOAT},
+	{wgpu::TextureFormat::Depth24PlusStencil8, DXGI_FORMAT_D24_UNORM_S8_UINT},
+	{wgpu::TextureFormat::Depth32FloatStencil8, DXGI_FORMAT_D32_FLOAT_S8X24_UINT},
+};
+
+DXGI_FORMAT getD3D12Format(wgpu::TextureFormat format) {
+	for (auto& it : swapchainFormats) {
+		if (it.dawnFormat == format) return it.d3d12Format;
+	}
+	return DXGI_FORMAT_UNKNOWN;
+}
+
+wgpu::TextureFormat getDawnFormat(int64_t format) {
+	for (auto& it : swapchainFormats) {
+		if (it.d3d12Format == (DXGI_FORMAT)format) return it.dawnFormat;
+	}
+	return wgpu::TextureFormat::Undefined;
+}
 
 struct D3D12Session : Session {
 
-	D3D12Session(XrSession session, const wgpu::Device& device) : Session(session, device) {
+	D3D12Session(XrSession session, const wgpu::Device& device, Instance* dispatch) : Session(session, device, dispatch) {
+	}
+
+	bool needsAttachmentOnRelease() const override {
+		return true;
 	}
 
 	XrResult enumerateSwapchainFormats(std::vector<wgpu::TextureFormat>& formats) override {
 
-		formats.push_back(dawnSwapchainFormat);
+		uint32_t n;
+		XR_TRY(XR_RUNTIME(dispatch->xrEnumerateSwapchainFormats(backendSession, 0, &n, nullptr)));
+
+		std::vector<int64_t> d3d12Formats(n);
+		XR_TRY(XR_RUNTIME(dispatch->xrEnumerateSwapchainFormats(backendSession, n, &n, d3d12Formats.data())));
+
+		// Keep runtime preference order, skipping anything we can't wrap.
+		for (auto i = 0u; i < n; ++i) {
+			auto format = getDawnFormat(d3d12Formats[i]);
+			if (format != wgpu::TextureFormat::Undefined && isSwapchainFormatSupported(device, format)) {
+				formats.push_back(format);
+			}
+		}
 
 		return XR_SUCCESS;
 	}
@@ -31,10 +78,14 @@ struct D3D12Session : Session {
 
 		if (createInfo->type != XR_TYPE_SWAPCHAIN_CREATE_INFO) return XR_ERROR_HANDLE_INVALID;
 
-		if (createInfo->format != (int64_t)dawnSwapchainFormat) return XR_ERROR_RUNTIME_FAILURE;
+		auto format = (wgpu::TextureFormat)createInfo->format;
+		auto d3d12Format = getD3D12Format(format);
+		if (d3d12Format == DXGI_FORMAT_UNKNOWN || !isSwapchainFormatSupported(device, format)) {
+			return XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+		}
 
 		auto d3d12Info = *createInfo;
-		d3d12Info.format = d3d12SwapchainFormat;
+		d3d12Info.format = d3d12Format;
 
 		if (0) {	// NOLINT
 			// Describe and create a Texture2D.
@@ -62,23 +113,35 @@ struct D3D12Session : Session {
 					  << std::endl;
 		}
 
-		XR_TRY(xrCreateSwapchain(backendSession, &d3d12Info, swapchain));
-		// TODO: Need to cleanup swapchain if any of the below fails
+		XR_TRY(XR_RUNTIME(dispatch->xrCreateSwapchain(backendSession, &d3d12Info, swapchain)));
+
+		auto r = wrapSwapchainImages(createInfo, *swapchain, images);
+		if (XR_FAILED(r)) {
+			images.clear();
+			XR_RUNTIME(dispatch->xrDestroySwapchain(*swapchain));
+		}
+
+		return r;
+	}
+
+	XrResult wrapSwapchainImages(const XrSwapchainCreateInfo* createInfo, XrSwapchain swapchain,
+								 std::vector<wgpu::Texture>& images) {
 
 		uint32_t n;
-		XR_TRY(xrEnumerateSwapchainImages(*swapchain, 0, &n, nullptr));
+		XR_TRY(XR_RUNTIME(dispatch->xrEnumerateSwapchainImages(swapchain, 0, &n, nullptr)));
 
 		std::vector<XrSwapchainImageD3D12KHR> d3d12Images(n, {XR_TYPE_SWAPCHAIN_IMAGE_D3D12_KHR});
-		XR_TRY(xrEnumerateSwapchainImages(*swapchain, n, &n, (XrSwapchainImageBaseHeader*)d3d12Images.data()));
+		XR_TRY(XR_RUNTIME(
+			dispatch->xrEnumerateSwapchainImages(swapchain, n, &n, (XrSwapchainImageBaseHeader*)d3d12Images.data())));
 		if (n != d3d12Images.size()) return XR_ERROR_RUNTIME_FAILURE;
 
 		wgpu::TextureDescriptor textureDesc{
 			nullptr,												  // nextInChain
 			nullptr,												  // label
-			wgpu::TextureUsage::RenderAttachment |					  // usage
-				wgpu::TextureUsage::TextureBinding,					  // ...does this need to be optional?
+			getSwapchainTextureUsage(createInfo->usageFlags),		  // usage
 			wgpu::TextureDimension::e2D,							  // dimension
-			wgpu::Extent3D{createInfo->width, createInfo->height, 1}, // size
+			wgpu::Extent3D{createInfo->width, createInfo->height,	  // size
+						   createInfo->arraySize},					  // ...array layers
 			(wgpu::TextureFormat)createInfo->format,				  // format
 			createInfo->mipCount,									  // mipLevelCount;
 			createInfo->sampleCount,								  // sampleCount;
@@ -89,6 +152,7 @@ struct D3D12Session : Session {
 		for (auto& it : d3d12Images) {
 			auto texture = wgpu::Texture(dawn::native::d3d12::CreateSwapchainWGPUTexture(
 				device.Get(), (WGPUTextureDescriptor*)&textureDesc, it.texture));
+			if (!texture) return XR_ERROR_RUNTIME_FAILURE;
 			images.push_back(texture);
 		}
 
@@ -96,45 +160,58 @@ struct D3D12Session : Session {
 	}
 };
 
+// Queries D3D12 requirements the first time they're needed. Call with the system mutex held.
+XrResult getD3D12Requirements(Instance* instance, System* system) {
+
+	if (system->d3d12Requirements) return XR_SUCCESS;
+
+	if (!instance->xrGetD3D12GraphicsRequirementsKHR) return XR_ERROR_FUNCTION_UNSUPPORTED;
+
+	XrGraphicsRequirementsD3D12KHR d3d12Reqs{XR_TYPE_GRAPHICS_REQUIREMENTS_D3D12_KHR};
+	XR_TRY(XR_RUNTIME(instance->xrGetD3D12GraphicsRequirementsKHR(instance->instance, system->systemId, &d3d12Reqs)));
+	system->d3d12Requirements = d3d12Reqs;
+
+	return XR_SUCCESS;
+}
+
 } // namespace
 
 namespace dawnxr::internal {
 
-XrResult getD3D12GraphicsRequirements(XrInstance instance, XrSystemId systemId, GraphicsRequirementsDawn* requirements) {
+XrResult getD3D12GraphicsRequirements(Instance* instance, XrSystemId systemId, GraphicsRequirementsDawn* requirements) {
 
-	PFN_xrGetD3D12GraphicsRequirementsKHR xrGetD3D12GraphicsRequirementsKHR = nullptr;
-	XR_TRY(xrGetInstanceProcAddr(instance, "xrGetD3D12GraphicsRequirementsKHR",
-								 (PFN_xrVoidFunction*)(&xrGetD3D12GraphicsRequirementsKHR)));
+	auto system = instance->getSystem(systemId);
+	std::lock_guard<std::mutex> lock(system->mutex);
 
-	XrGraphicsRequirementsD3D12KHR d3d12Reqs{XR_TYPE_GRAPHICS_REQUIREMENTS_D3D12_KHR};
-	XR_TRY(xrGetD3D12GraphicsRequirementsKHR(instance, systemId, &d3d12Reqs));
+	XR_TRY(getD3D12Requirements(instance, system));
 
-//	std::cout << "### D3D12 graphics requirements minFeatureLevel: " << d3d12Reqs.minFeatureLevel << std::endl;
-//	std::cout << "### D3D12 graphics requirements adapterLuid: " << d3d12Reqs.adapterLuid.HighPart << " "
-//			  << d3d12Reqs.adapterLuid.LowPart << std::endl;
+//	std::cout << "### D3D12 graphics requirements minFeatureLevel: " << system->d3d12Requirements->minFeatureLevel << std::endl;
+//	std::cout << "### D3D12 graphics requirements adapterLuid: " << system->d3d12Requirements->adapterLuid.HighPart << " "
+//			  << system->d3d12Requirements->adapterLuid.LowPart << std::endl;
 
 	return XR_SUCCESS;
 }
 
-XrResult createD3D12RequestAdapterOptions(XrInstance instance, XrSystemId systemId, wgpu::ChainedStruct** opts) {
+XrResult createD3D12RequestAdapterOptions(Instance* instance, XrSystemId systemId, wgpu::ChainedStruct** opts) {
 
 	// TODO: Should really add a D3D_FEATURE_LEVEL adapter option to dawn, as it's hardcoded to 11_0 in dawn but OpenXR wants 12_0.
 
-	PFN_xrGetD3D12GraphicsRequirementsKHR xrGetD3D12GraphicsRequirementsKHR = nullptr;
-	XR_TRY(xrGetInstanceProcAddr(instance, "xrGetD3D12GraphicsRequirementsKHR",
-								 (PFN_xrVoidFunction*)(&xrGetD3D12GraphicsRequirementsKHR)));
+	auto system = instance->getSystem(systemId);
+	std::lock_guard<std::mutex> lock(system->mutex);
 
-	XrGraphicsRequirementsD3D12KHR d3d12Reqs{XR_TYPE_GRAPHICS_REQUIREMENTS_D3D12_KHR};
-	XR_TRY(xrGetD3D12GraphicsRequirementsKHR(instance, systemId, &d3d12Reqs));
+	if (!system->d3d12AdapterOptions) {
+		XR_TRY(getD3D12Requirements(instance, system));
 
-	auto adapterOpts = new dawn::native::d3d::RequestAdapterOptionsLUID();
-	adapterOpts->adapterLUID = d3d12Reqs.adapterLuid;
-	*opts = adapterOpts;
+		auto adapterOpts = std::make_shared<dawn::native::d3d::RequestAdapterOptionsLUID>();
+		adapterOpts->adapterLUID = system->d3d12Requirements->adapterLuid;
+		system->d3d12AdapterOptions = adapterOpts;
+	}
+	*opts = system->d3d12AdapterOptions.get();
 
 	return XR_SUCCESS;
 }
 
-XrResult createD3D12Session(XrInstance instance, const XrSessionCreateInfo* createInfo, Session** session) {
+XrResult createD3D12Session(Instance* instance, const XrSessionCreateInfo* createInfo, Session** session) {
 
 	if (createInfo->type != XR_TYPE_SESSION_CREATE_INFO) return XR_ERROR_HANDLE_INVALID;
 
@@ -155,8 +232,8 @@ XrResult createD3D12Session(XrInstance instance, const XrSessionCreateInfo* crea
 	d3d12CreateInfo.systemId = createInfo->systemId;
 
 	XrSession backendSession;
-	XR_TRY(xrCreateSession(instance, &d3d12CreateInfo, &backendSession));
-	*session = new D3D12Session(backendSession, dawnDevice);
+	XR_TRY(XR_RUNTIME(instance->xrCreateSession(instance->instance, &d3d12CreateInfo, &backendSession)));
+	*session = new D3D12Session(backendSession, dawnDevice, instance);
 
 	return XR_SUCCESS;
 }
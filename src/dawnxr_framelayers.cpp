@@ -0,0 +1,180 @@
+#include "dawnxr_internal.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+// Bump allocator for a frame's layer structs. Blocks are kept on reset, so once the first few frames have grown it to
+// the app's high water mark it never allocates again.
+class FrameArena {
+public:
+	template <class T> T* alloc(uint32_t count) {
+
+		static_assert(std::is_trivially_destructible_v<T>, "Arena structs are never destroyed");
+
+		auto size = sizeof(T) * count;
+		offset = (offset + alignof(T) - 1) & ~(alignof(T) - 1);
+
+		while (block < blocks.size() && offset + size > blocks[block].size) {
+			++block;
+			offset = 0;
+		}
+		if (block == blocks.size()) {
+			auto blockSize = std::max(minBlockSize, size);
+			blocks.push_back({std::make_unique<std::byte[]>(blockSize), blockSize});
+		}
+
+		auto data = blocks[block].data.get() + offset;
+		offset += size;
+
+		auto p = (T*)data;
+		for (auto i = 0u; i < count; ++i) new (p + i) T{};
+		return p;
+	}
+
+	void reset() {
+		block = 0;
+		offset = 0;
+	}
+
+private:
+	static constexpr size_t minBlockSize = 16384;
+
+	struct Block {
+		std::unique_ptr<std::byte[]> data;
+		size_t size;
+	};
+
+	std::vector<Block> blocks;
+	size_t block = 0;
+	size_t offset = 0;
+};
+
+// Empty rects mean the whole swapchain, or its dynamic resolution rect.
+XrSwapchainSubImage resolveSubImage(const XrSwapchainSubImage& subImage) {
+
+	auto result = subImage;
+	if (!result.imageRect.extent.width || !result.imageRect.extent.height) {
+		dawnxr::getDynamicResolutionRect(subImage.swapchain, &result.imageRect);
+	}
+	return result;
+}
+
+} // namespace
+
+namespace dawnxr {
+
+struct FrameLayers {
+	FrameArena arena;
+	std::vector<const XrCompositionLayerBaseHeader*> layers;
+	XrCompositionLayerProjection* lastProjection = nullptr;
+};
+
+XrResult createFrameLayers(FrameLayers** frameLayers) {
+
+	XR_TIMER("createFrameLayers");
+
+	*frameLayers = new FrameLayers();
+
+	return XR_SUCCESS;
+}
+
+XrResult destroyFrameLayers(FrameLayers* frameLayers) {
+
+	XR_TIMER("destroyFrameLayers");
+
+	delete frameLayers;
+
+	return XR_SUCCESS;
+}
+
+XrResult resetFrameLayers(FrameLayers* frameLayers) {
+
+	frameLayers->arena.reset();
+	frameLayers->layers.clear();
+	frameLayers->lastProjection = nullptr;
+
+	return XR_SUCCESS;
+}
+
+XrResult addProjectionLayer(FrameLayers* frameLayers, XrSpace space, XrCompositionLayerFlags layerFlags,
+							uint32_t viewCount, const XrView* views, const XrSwapchainSubImage* subImages) {
+
+	XR_TIMER("addProjectionLayer");
+
+	if (!viewCount) return XR_ERROR_VALIDATION_FAILURE;
+
+	auto projectionViews = frameLayers->arena.alloc<XrCompositionLayerProjectionView>(viewCount);
+	for (auto i = 0u; i < viewCount; ++i) {
+		auto& projectionView = projectionViews[i];
+		projectionView.type = XR_TYPE_COMPOSITION_LAYER_PROJECTION_VIEW;
+		projectionView.pose = views[i].pose;
+		projectionView.fov = views[i].fov;
+		projectionView.subImage = resolveSubImage(subImages[i]);
+	}
+
+	auto layer = frameLayers->arena.alloc<XrCompositionLayerProjection>(1);
+	layer->type = XR_TYPE_COMPOSITION_LAYER_PROJECTION;
+	layer->layerFlags = layerFlags;
+	layer->space = space;
+	layer->viewCount = viewCount;
+	layer->views = projectionViews;
+
+	frameLayers->layers.push_back((const XrCompositionLayerBaseHeader*)layer);
+	frameLayers->lastProjection = layer;
+
+	return XR_SUCCESS;
+}
+
+XrResult addProjectionDepth(FrameLayers* frameLayers, XrSwapchain depthSwapchain, float nearZ, float farZ) {
+
+	XR_TIMER("addProjectionDepth");
+
+	auto layer = frameLayers->lastProjection;
+	if (!layer) return XR_ERROR_CALL_ORDER_INVALID;
+
+	auto depthInfos = frameLayers->arena.alloc<XrCompositionLayerDepthInfoKHR>(layer->viewCount);
+
+	// Views are only const to the runtime, they're ours until endFrame.
+	return chainDepthInfos(depthSwapchain, nearZ, farZ, layer->viewCount,
+						   const_cast<XrCompositionLayerProjectionView*>(layer->views), depthInfos);
+}
+
+XrResult addQuadLayer(FrameLayers* frameLayers, XrSpace space, XrCompositionLayerFlags layerFlags,
+					  const XrSwapchainSubImage* subImage, const XrPosef* pose, const XrExtent2Df* size) {
+
+	XR_TIMER("addQuadLayer");
+
+	auto layer = frameLayers->arena.alloc<XrCompositionLayerQuad>(1);
+	layer->type = XR_TYPE_COMPOSITION_LAYER_QUAD;
+	layer->layerFlags = layerFlags;
+	layer->space = space;
+	layer->eyeVisibility = XR_EYE_VISIBILITY_BOTH;
+	layer->subImage = resolveSubImage(*subImage);
+	layer->pose = *pose;
+	layer->size = *size;
+
+	frameLayers->layers.push_back((const XrCompositionLayerBaseHeader*)layer);
+
+	return XR_SUCCESS;
+}
+
+XrResult getFrameEndInfo(FrameLayers* frameLayers, XrTime displayTime, XrEnvironmentBlendMode blendMode,
+						 XrFrameEndInfo* endInfo) {
+
+	if (endInfo->type != XR_TYPE_FRAME_END_INFO) return XR_ERROR_VALIDATION_FAILURE;
+
+	endInfo->displayTime = displayTime;
+	endInfo->environmentBlendMode = blendMode;
+	endInfo->layerCount = (uint32_t)frameLayers->layers.size();
+	endInfo->layers = frameLayers->layers.data();
+
+	return XR_SUCCESS;
+}
+
+} // namespace dawnxr
@@ -0,0 +1,164 @@
+#include "dawnxr_internal.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+namespace dawnxr {
+
+struct FrameLoop {
+
+	XrSession const session;
+	wgpu::Device const device;
+	wgpu::Queue const queue;
+	uint32_t const renderAheadDepth;
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool stopping = false;
+
+	// Frame state produced by the wait thread, consumed by acquireFrame.
+	bool framePending = false;
+	XrFrameState frameState{XR_TYPE_FRAME_STATE};
+	XrResult frameResult = XR_SUCCESS;
+
+	// Frames submitted with submitFrame that the GPU hasn't finished yet, signalled by their work done callbacks.
+	std::mutex gpuMutex;
+	std::condition_variable gpuCond;
+	uint32_t framesInFlight = 0;
+
+	std::thread waitThread;
+
+	FrameLoop(XrSession session, const wgpu::Device& device, uint32_t renderAheadDepth)
+		: session(session), device(device), queue(device.GetQueue()), renderAheadDepth(renderAheadDepth) {
+		waitThread = std::thread([this] { waitFrames(); });
+	}
+
+	~FrameLoop() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		cond.notify_all();
+		waitThread.join();
+
+		// Work done callbacks reference us.
+		waitFramesInFlight(0);
+	}
+
+	void waitFrames() {
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				cond.wait(lock, [this] { return stopping || !framePending; });
+				if (stopping) return;
+			}
+
+			XrFrameState state{XR_TYPE_FRAME_STATE};
+			auto r = waitFrame(session, nullptr, &state);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				frameState = state;
+				frameResult = r;
+				framePending = true;
+			}
+			cond.notify_all();
+
+			if (XR_FAILED(r)) return;
+		}
+	}
+
+	// Blocks until at most maxFrames frames are on the GPU. Work done callbacks only run when the device is ticked, so
+	// ticks at most once per tickInterval while waiting, in case no other thread is ticking it, rather than spinning.
+	void waitFramesInFlight(uint32_t maxFrames) {
+		constexpr auto tickInterval = std::chrono::milliseconds(1);
+
+		std::unique_lock<std::mutex> lock(gpuMutex);
+		while (framesInFlight > maxFrames) {
+			lock.unlock();
+			device.Tick();
+			lock.lock();
+			gpuCond.wait_for(lock, tickInterval, [=] { return framesInFlight <= maxFrames; });
+		}
+	}
+
+	void frameDone() {
+		// Notifies with the lock held, so a destructor waiting for the last frame can't free us until we're done.
+		std::lock_guard<std::mutex> lock(gpuMutex);
+		--framesInFlight;
+		gpuCond.notify_all();
+	}
+};
+
+XrResult createFrameLoop(XrSession session, uint32_t renderAheadDepth, FrameLoop** frameLoop) {
+
+	XR_TIMER("createFrameLoop");
+
+	if (!renderAheadDepth) return XR_ERROR_VALIDATION_FAILURE;
+
+	auto dawnSession = internal::findSession(session);
+	if (!dawnSession) return XR_ERROR_HANDLE_INVALID;
+
+	*frameLoop = new FrameLoop(session, dawnSession->device, renderAheadDepth);
+
+	return XR_SUCCESS;
+}
+
+XrResult destroyFrameLoop(FrameLoop* frameLoop) {
+
+	XR_TIMER("destroyFrameLoop");
+
+	delete frameLoop;
+
+	return XR_SUCCESS;
+}
+
+XrResult acquireFrame(FrameLoop* frameLoop, XrFrameState* frameState) {
+
+	XR_TIMER("acquireFrame");
+
+	if (frameState->type != XR_TYPE_FRAME_STATE) return XR_ERROR_VALIDATION_FAILURE;
+
+	// Throttle the CPU to renderAheadDepth frames ahead of the GPU.
+	frameLoop->waitFramesInFlight(frameLoop->renderAheadDepth - 1);
+
+	XrResult r;
+	{
+		std::unique_lock<std::mutex> lock(frameLoop->mutex);
+		frameLoop->cond.wait(lock, [frameLoop] { return frameLoop->framePending; });
+
+		frameState->predictedDisplayTime = frameLoop->frameState.predictedDisplayTime;
+		frameState->predictedDisplayPeriod = frameLoop->frameState.predictedDisplayPeriod;
+		frameState->shouldRender = frameLoop->frameState.shouldRender;
+		r = frameLoop->frameResult;
+
+		// A failed wait stops the wait thread, so leave it pending for any further calls to return.
+		if (XR_SUCCEEDED(r)) {
+			r = beginFrame(frameLoop->session, nullptr);
+			// The wait thread can start waiting for the next frame once this one has begun.
+			frameLoop->framePending = false;
+		}
+	}
+	frameLoop->cond.notify_all();
+
+	return r;
+}
+
+XrResult submitFrame(FrameLoop* frameLoop, const XrFrameEndInfo* endInfo) {
+
+	XR_TIMER("submitFrame");
+
+	{
+		std::lock_guard<std::mutex> lock(frameLoop->gpuMutex);
+		++frameLoop->framesInFlight;
+	}
+	frameLoop->queue.OnSubmittedWorkDone(
+		[](WGPUQueueWorkDoneStatus, void* userdata) { ((FrameLoop*)userdata)->frameDone(); }, frameLoop);
+
+	return endFrame(frameLoop->session, endInfo);
+}
+
+} // namespace dawnxr
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+namespace dawnxr::internal {
+
+// Concurrent map from XR handles to dawnxr objects.
+//
+// find() is wait-free: the table is open addressed with atomic key/value slots that readers probe without taking any
+// locks. Writers are serialized by a mutex that readers never touch, so creating/destroying swapchains on one thread
+// never stalls lookups on another. Erased slots keep their key as a tombstone so probe chains stay intact. When the
+// table fills up a larger copy is published and the old one is retired, as readers may still be probing it.
+//
+// Readers announce themselves in per-thread counter shards, each on its own cache line, so concurrent finds on different
+// threads don't bounce a shared counter between cores. Writers sum the shards, and only free retired tables or recycle
+// tombstones when no find is in flight, so both happen at the first insert/erase after lookups go quiet. A find that
+// starts after that check can still read a tombstone's old key just before it's recycled, so finds re-read the key after
+// the value and miss if it changed. As recycling waits for that find to finish, the key can't change back in between.
+//
+// The map doesn't own its values, and it's up to the caller to make sure a value isn't deleted while another thread
+// still uses it, same as with the XR handle itself.
+template <class K, class V> class HandleMap {
+public:
+	HandleMap() {
+		publish(minCapacity);
+	}
+
+	HandleMap(const HandleMap&) = delete;
+	HandleMap& operator=(const HandleMap&) = delete;
+
+	V* find(K handle) const {
+
+		auto key = toKey(handle);
+
+		// All seq_cst so a writer that publishes a new table or erases an entry, then sees no readers, knows every find
+		// in flight started after, and sees the new table and the erase.
+		auto& shard = readers[getReaderShard()].count;
+		shard.fetch_add(1, std::memory_order_seq_cst);
+		auto table = current.load(std::memory_order_seq_cst);
+
+		V* value = nullptr;
+		for (auto i = hash(key) & table->mask;; i = (i + 1) & table->mask) {
+			auto& slot = table->slots[i];
+			auto slotKey = slot.key.load(std::memory_order_seq_cst);
+			if (slotKey == key) {
+				value = slot.value.load(std::memory_order_seq_cst);
+				// The slot was recycled for another key between the two loads, so ours was erased.
+				if (slot.key.load(std::memory_order_seq_cst) != key) value = nullptr;
+			}
+			if (slotKey == key || !slotKey) break;
+		}
+
+		shard.fetch_sub(1, std::memory_order_release);
+
+		return value;
+	}
+
+	bool insert(K handle, V* value) {
+
+		auto key = toKey(handle);
+		if (!key || !value) return false;
+
+		std::lock_guard<std::mutex> lock(writeMutex);
+
+		auto table = current.load(std::memory_order_relaxed);
+		if ((used + 1) * 4 > table->capacity() * 3) {
+			table = rehash(live + 1);
+			reclaim();
+		}
+
+		auto& slot = table->slots[probe(table, key)];
+		if (slot.value.load(std::memory_order_relaxed)) return false;
+
+		if (!slot.key.load(std::memory_order_relaxed)) {
+			// Recycle a tombstone in the probe chain if there is one and no find is in flight, see above. Readers
+			// probing for other keys just skip over it.
+			auto tombstone = findTombstone(table, key);
+			if (tombstone && !hasReaders()) {
+				// Readers that see the new key before its value just miss, as if insert hadn't happened yet.
+				tombstone->key.store(key, std::memory_order_seq_cst);
+				tombstone->value.store(value, std::memory_order_seq_cst);
+				++live;
+				return true;
+			}
+			++used;
+		}
+
+		// Publish value before key so readers that see the key also see the value.
+		slot.value.store(value, std::memory_order_release);
+		slot.key.store(key, std::memory_order_release);
+		++live;
+
+		return true;
+	}
+
+	V* erase(K handle) {
+
+		auto key = toKey(handle);
+		if (!key) return nullptr;
+
+		std::lock_guard<std::mutex> lock(writeMutex);
+
+		reclaim();
+
+		auto table = current.load(std::memory_order_relaxed);
+
+		auto& slot = table->slots[probe(table, key)];
+		auto value = slot.value.exchange(nullptr, std::memory_order_seq_cst);
+		if (value) --live;
+
+		return value;
+	}
+
+	// Calls f(handle, value) for each live entry. Holds the writer lock so f must not insert or erase.
+	template <class F> void forEach(F f) const {
+
+		std::lock_guard<std::mutex> lock(writeMutex);
+
+		auto table = current.load(std::memory_order_relaxed);
+		for (auto& slot : table->slots) {
+			auto value = slot.value.load(std::memory_order_relaxed);
+			if (value) f(fromKey(slot.key.load(std::memory_order_relaxed)), value);
+		}
+	}
+
+private:
+	static constexpr size_t minCapacity = 16;
+	static constexpr size_t readerShardCount = 16;
+
+	struct Slot {
+		std::atomic<uint64_t> key{};
+		std::atomic<V*> value{};
+	};
+
+	struct alignas(64) ReaderShard {
+		std::atomic<uint32_t> count{}; // finds in flight on the threads using this shard
+	};
+
+	struct Table {
+		std::vector<Slot> slots;
+		size_t const mask;
+
+		explicit Table(size_t capacity) : slots(capacity), mask(capacity - 1) {
+		}
+
+		size_t capacity() const {
+			return slots.size();
+		}
+	};
+
+	std::atomic<Table*> current{};
+	std::vector<std::unique_ptr<Table>> tables; // Retired tables, then the current one
+	mutable ReaderShard readers[readerShardCount];
+	mutable std::mutex writeMutex;
+	size_t used = 0; // Slots with a key, including tombstones
+	size_t live = 0; // Slots with a value
+
+	static uint64_t toKey(K handle) {
+		if constexpr (std::is_pointer_v<K>) {
+			return (uint64_t)(uintptr_t)handle;
+		} else {
+			return (uint64_t)handle;
+		}
+	}
+
+	static K fromKey(uint64_t key) {
+		if constexpr (std::is_pointer_v<K>) {
+			return (K)(uintptr_t)key;
+		} else {
+			return (K)key;
+		}
+	}
+
+	static size_t hash(uint64_t key) {
+		// splitmix64 finalizer, handles are often aligned pointers.
+		key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+		key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+		return (size_t)(key ^ (key >> 31));
+	}
+
+	// Threads are spread over the shards round robin, in the order they first call find on any map of this type.
+	static size_t getReaderShard() {
+		static std::atomic<size_t> nextShard{};
+		thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % readerShardCount;
+		return shard;
+	}
+
+	bool hasReaders() const {
+		for (auto& shard : readers) {
+			if (shard.count.load(std::memory_order_seq_cst)) return true;
+		}
+		return false;
+	}
+
+	// Returns the slot holding key, or the empty slot ending its probe chain.
+	static size_t probe(const Table* table, uint64_t key) {
+		for (auto i = hash(key) & table->mask;; i = (i + 1) & table->mask) {
+			auto slotKey = table->slots[i].key.load(std::memory_order_relaxed);
+			if (slotKey == key || !slotKey) return i;
+		}
+	}
+
+	static Slot* findTombstone(Table* table, uint64_t key) {
+		for (auto i = hash(key) & table->mask;; i = (i + 1) & table->mask) {
+			auto& slot = table->slots[i];
+			if (!slot.key.load(std::memory_order_relaxed)) return nullptr;
+			if (!slot.value.load(std::memory_order_relaxed)) return &slot;
+		}
+	}
+
+	// Frees retired tables if no find is in flight. Any find that starts after this loads the current table.
+	void reclaim() {
+		if (tables.size() < 2 || hasReaders()) return;
+		tables.erase(tables.begin(), tables.end() - 1);
+	}
+
+	Table* publish(size_t capacity) {
+		tables.push_back(std::make_unique<Table>(capacity));
+		auto table = tables.back().get();
+		current.store(table, std::memory_order_seq_cst);
+		return table;
+	}
+
+	// Copies live entries into a new table, dropping tombstones.
+	Table* rehash(size_t count) {
+
+		auto capacity = minCapacity;
+		while (capacity < count * 2) capacity *= 2;
+
+		auto from = current.load(std::memory_order_relaxed);
+		auto table = std::make_unique<Table>(capacity);
+
+		for (auto& slot : from->slots) {
+			auto value = slot.value.load(std::memory_order_relaxed);
+			if (!value) continue;
+			auto key = slot.key.load(std::memory_order_relaxed);
+			auto& to = table->slots[probe(table.get(), key)];
+			to.value.store(value, std::memory_order_relaxed);
+			to.key.store(key, std::memory_order_relaxed);
+		}
+		used = live;
+
+		tables.push_back(std::move(table));
+		current.store(tables.back().get(), std::memory_order_seq_cst);
+
+		return tables.back().get();
+	}
+};
+
+} // namespace dawnxr::internal
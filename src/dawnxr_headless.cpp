@@ -0,0 +1,201 @@
+#include "dawnxr_internal.h"
+#include "dawnxr_handlemap.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace dawnxr::internal;
+
+namespace {
+
+// Same formats as the D3D12 table, in a typical runtime's preference order.
+constexpr wgpu::TextureFormat swapchainFormats[] = {
+	wgpu::TextureFormat::BGRA8UnormSrgb,	  wgpu::TextureFormat::RGBA8UnormSrgb, wgpu::TextureFormat::BGRA8Unorm,
+	wgpu::TextureFormat::RGBA8Unorm,		  wgpu::TextureFormat::RGBA16Float,	   wgpu::TextureFormat::RGB10A2Unorm,
+	wgpu::TextureFormat::RG11B10Ufloat,		  wgpu::TextureFormat::RGBA32Float,	   wgpu::TextureFormat::Depth32Float,
+	wgpu::TextureFormat::Depth24PlusStencil8, wgpu::TextureFormat::Depth16Unorm,   wgpu::TextureFormat::Depth32FloatStencil8,
+};
+
+// Ring of plain dawn textures standing in for runtime swapchain images.
+struct HeadlessSwapchain {
+	uint32_t const imageCount;
+	uint32_t nextImage = 0;
+};
+
+struct HeadlessSession : Session {
+
+	XrDuration const displayPeriod;
+	bool const throttle;
+
+	XrTime vsyncTime = 0;
+
+	HandleMap<XrSwapchain, HeadlessSwapchain> swapchains;
+
+	// Headless sessions don't have a runtime handle, so use the session address as one.
+	HeadlessSession(const wgpu::Device& device, XrDuration displayPeriod, bool throttle)
+		: Session((XrSession)(uintptr_t)this, device, nullptr), displayPeriod(displayPeriod), throttle(throttle) {
+	}
+
+	~HeadlessSession() override {
+		swapchains.forEach([](XrSwapchain, HeadlessSwapchain* headlessSwapchain) { delete headlessSwapchain; });
+	}
+
+	XrResult enumerateSwapchainFormats(std::vector<wgpu::TextureFormat>& formats) override {
+
+		for (auto format : swapchainFormats) {
+			if (isSwapchainFormatSupported(device, format)) formats.push_back(format);
+		}
+
+		return XR_SUCCESS;
+	}
+
+	XrResult createSwapchain(const XrSwapchainCreateInfo* createInfo, std::vector<wgpu::Texture>& images,
+							 XrSwapchain* swapchain) override {
+
+		if (createInfo->type != XR_TYPE_SWAPCHAIN_CREATE_INFO) return XR_ERROR_HANDLE_INVALID;
+
+		auto format = (wgpu::TextureFormat)createInfo->format;
+		if (std::find(std::begin(swapchainFormats), std::end(swapchainFormats), format) == std::end(swapchainFormats) ||
+			!isSwapchainFormatSupported(device, format)) {
+			return XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+		}
+
+		// Most runtimes use 3 images, static images only need 1.
+		uint32_t n = (createInfo->createFlags & XR_SWAPCHAIN_CREATE_STATIC_IMAGE_BIT) ? 1 : 3;
+
+		wgpu::TextureDescriptor textureDesc{
+			nullptr,												  // nextInChain
+			nullptr,												  // label
+			getSwapchainTextureUsage(createInfo->usageFlags),		  // usage
+			wgpu::TextureDimension::e2D,							  // dimension
+			wgpu::Extent3D{createInfo->width, createInfo->height,	  // size
+						   createInfo->arraySize},					  // ...array layers
+			format,													  // format
+			createInfo->mipCount,									  // mipLevelCount;
+			createInfo->sampleCount,								  // sampleCount;
+			0,														  // viewFormatCount;
+			nullptr													  // view formats
+		};
+
+		for (auto i = 0u; i < n; ++i) {
+			auto texture = device.CreateTexture(&textureDesc);
+			if (!texture) return XR_ERROR_RUNTIME_FAILURE;
+			images.push_back(texture);
+		}
+
+		auto headlessSwapchain = new HeadlessSwapchain{n};
+		*swapchain = (XrSwapchain)(uintptr_t)headlessSwapchain;
+		swapchains.insert(*swapchain, headlessSwapchain);
+
+		return XR_SUCCESS;
+	}
+
+	XrResult destroySwapchain(XrSwapchain swapchain) override {
+
+		auto headlessSwapchain = swapchains.erase(swapchain);
+		if (!headlessSwapchain) return XR_ERROR_HANDLE_INVALID;
+		delete headlessSwapchain;
+
+		return XR_SUCCESS;
+	}
+
+	XrResult acquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo,
+								   uint32_t* index) override {
+
+		auto headlessSwapchain = swapchains.find(swapchain);
+		if (!headlessSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+		*index = headlessSwapchain->nextImage;
+		headlessSwapchain->nextImage = (headlessSwapchain->nextImage + 1) % headlessSwapchain->imageCount;
+
+		return XR_SUCCESS;
+	}
+
+	XrResult waitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo) override {
+
+		return swapchains.find(swapchain) ? XR_SUCCESS : XR_ERROR_HANDLE_INVALID;
+	}
+
+	XrResult releaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo) override {
+
+		return swapchains.find(swapchain) ? XR_SUCCESS : XR_ERROR_HANDLE_INVALID;
+	}
+
+	XrResult beginSession(const XrSessionBeginInfo* beginInfo) override {
+
+		return XR_SUCCESS;
+	}
+
+	XrResult endSession() override {
+
+		return XR_SUCCESS;
+	}
+
+	XrResult waitFrame(const XrFrameWaitInfo* waitInfo, XrFrameState* frameState) override {
+
+		if (frameState->type != XR_TYPE_FRAME_STATE) return XR_ERROR_VALIDATION_FAILURE;
+
+		auto time = getTime();
+		if (!vsyncTime) vsyncTime = time;
+
+		vsyncTime += displayPeriod;
+
+		if (throttle) {
+			// Skip any vsyncs we've missed like a real compositor would, then wait for the next one.
+			if (vsyncTime < time) vsyncTime += (time - vsyncTime + displayPeriod - 1) / displayPeriod * displayPeriod;
+			// Counted as runtime time, so wrapper overhead can be measured against the virtual compositor.
+			auto wakeTime = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(vsyncTime));
+			XR_RUNTIME(std::this_thread::sleep_until(wakeTime));
+		}
+
+		frameState->predictedDisplayTime = vsyncTime + displayPeriod;
+		frameState->predictedDisplayPeriod = displayPeriod;
+		frameState->shouldRender = XR_TRUE;
+
+		return XR_SUCCESS;
+	}
+
+	XrResult beginFrame(const XrFrameBeginInfo* beginInfo) override {
+
+		return XR_SUCCESS;
+	}
+
+	XrResult endFrame(const XrFrameEndInfo* endInfo) override {
+
+		if (endInfo->type != XR_TYPE_FRAME_END_INFO) return XR_ERROR_VALIDATION_FAILURE;
+
+		return XR_SUCCESS;
+	}
+
+	XrResult destroySession() override {
+
+		return XR_SUCCESS;
+	}
+};
+
+} // namespace
+
+namespace dawnxr::internal {
+
+XrResult createHeadlessSession(const XrSessionCreateInfo* createInfo, Session** session) {
+
+	if (createInfo->type != XR_TYPE_SESSION_CREATE_INFO) return XR_ERROR_HANDLE_INVALID;
+
+	auto dawnBinding = (GraphicsBindingDawn*)createInfo->next;
+	if (dawnBinding->type != XR_TYPE_GRAPHICS_BINDING_DAWN_EXT) return XR_ERROR_HANDLE_INVALID;
+
+	HeadlessSessionCreateInfoDawn headlessInfo{};
+	if (auto info = findNext<HeadlessSessionCreateInfoDawn>(dawnBinding->next, XR_TYPE_HEADLESS_SESSION_CREATE_INFO_DAWN_EXT)) {
+		headlessInfo = *info;
+	}
+	if (headlessInfo.displayPeriod <= 0) return XR_ERROR_VALIDATION_FAILURE;
+
+	*session = new HeadlessSession(dawnBinding->device, headlessInfo.displayPeriod, headlessInfo.throttle);
+
+	return XR_SUCCESS;
+}
+
+} // namespace dawnxr::internal
@@ -4,6 +4,11 @@
 
 #include <dawn/native/DawnNative.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 #include <vector>
 
 #define XR_TRY(X)                                                                                                              \
@@ -15,41 +20,575 @@
 		}                                                                                                                      \
 	}
 
-#define XR_PROC(XRINST, FUNCID)                                                                                                \
-	PFN_##FUNCID FUNCID{};                                                                                                     \
-	xrGetInstanceProcAddr((XRINST), #FUNCID, (PFN_xrVoidFunction*)(&FUNCID));
+// Entry points resolved into each Instance's dispatch table.
+#define XR_CORE_PROCS(X)                                                                                                       \
+	X(xrGetInstanceProperties)                                                                                                 \
+	X(xrCreateSession)                                                                                                         \
+	X(xrDestroySession)                                                                                                        \
+	X(xrBeginSession)                                                                                                          \
+	X(xrEndSession)                                                                                                            \
+	X(xrWaitFrame)                                                                                                             \
+	X(xrBeginFrame)                                                                                                            \
+	X(xrEndFrame)                                                                                                              \
+	X(xrEnumerateSwapchainFormats)                                                                                             \
+	X(xrCreateSwapchain)                                                                                                       \
+	X(xrDestroySwapchain)                                                                                                      \
+	X(xrEnumerateSwapchainImages)                                                                                              \
+	X(xrAcquireSwapchainImage)                                                                                                 \
+	X(xrWaitSwapchainImage)                                                                                                    \
+	X(xrReleaseSwapchainImage)
+
+#ifdef XR_USE_GRAPHICS_API_D3D12
+#define XR_D3D12_PROCS(X) X(xrGetD3D12GraphicsRequirementsKHR)
+#else
+#define XR_D3D12_PROCS(X)
+#endif
+
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+#define XR_VULKAN_PROCS(X)                                                                                                     \
+	X(xrGetVulkanGraphicsRequirements2KHR)                                                                                     \
+	X(xrCreateVulkanInstanceKHR)                                                                                               \
+	X(xrGetVulkanGraphicsDevice2KHR)                                                                                           \
+	X(xrCreateVulkanDeviceKHR)
+#else
+#define XR_VULKAN_PROCS(X)
+#endif
+
+#define XR_PROC(FUNCID) PFN_##FUNCID FUNCID{};
+
+// Records the duration of the enclosing scope as a timing event when timing is enabled.
+#define XR_TIMER(NAME) dawnxr::internal::ScopedTimer xrTimer(NAME)
+
+// Evaluates X, a call into the runtime, counting its duration as runtime time of the enclosing XR_TIMER, see
+// getCallStats.
+#define XR_RUNTIME(X) [&] { dawnxr::internal::RuntimeTimer xrRuntimeTimer; return (X); }()
 
 namespace dawnxr::internal {
 
+// Finds a struct of the given type in a next chain.
+template <class T> const T* findNext(const void* next, XrStructureType type) {
+	for (auto it = (const XrBaseInStructure*)next; it; it = it->next) {
+		if (it->type == type) return (const T*)it;
+	}
+	return nullptr;
+}
+
+// Current steady clock time in nanoseconds.
+XrTime getTime();
+
+extern std::atomic<bool> g_timingEnabled;
+
+// Small per-thread index for timing events.
+uint32_t getTimingThreadId();
+
+// Index of the frame currently being timed.
+uint64_t getTimingFrameIndex();
+
+// Records a timing event for the current frame, or for an earlier frame if it's still in the timing ring.
+void recordTimingEvent(const char* name, uint32_t threadId, XrTime beginTime, XrTime endTime, uint64_t frameIndex = ~0ull);
+
+// Completes the current frame, called by endFrame.
+void endTimingFrame();
+
+// Adds a call to the per entry point stats returned by getCallStats.
+void recordCallStats(const char* name, XrDuration totalTime, XrDuration runtimeTime);
+
+struct ScopedTimer;
+
+// Innermost running ScopedTimer on this thread, nullptr while timing is disabled.
+extern thread_local ScopedTimer* g_currentTimer;
+
+struct ScopedTimer {
+	const char* const name;
+	XrTime const beginTime;
+	ScopedTimer* const parent;
+	XrDuration runtimeTime = 0; // Includes runtime time of nested timers
+
+	explicit ScopedTimer(const char* name)
+		: name(name), beginTime(g_timingEnabled.load(std::memory_order_relaxed) ? getTime() : 0),
+		  parent(beginTime ? g_currentTimer : nullptr) {
+		if (beginTime) g_currentTimer = this;
+	}
+
+	~ScopedTimer() {
+		if (!beginTime) return;
+		auto endTime = getTime();
+		recordTimingEvent(name, getTimingThreadId(), beginTime, endTime);
+		recordCallStats(name, endTime - beginTime, runtimeTime);
+		g_currentTimer = parent;
+		if (parent) parent->runtimeTime += runtimeTime;
+	}
+};
+
+// Adds the duration of the enclosing scope to the current ScopedTimer's runtime time, see XR_RUNTIME.
+struct RuntimeTimer {
+	ScopedTimer* const timer;
+	XrTime const beginTime;
+
+	RuntimeTimer()
+		: timer(g_timingEnabled.load(std::memory_order_relaxed) ? g_currentTimer : nullptr),
+		  beginTime(timer ? getTime() : 0) {
+	}
+
+	~RuntimeTimer() {
+		if (timer) timer->runtimeTime += getTime() - beginTime;
+	}
+};
+
+// Per XrSystemId state cached by an Instance, so sessions can be recreated without redundant runtime round trips.
+struct System {
+
+	XrSystemId const systemId;
+
+	std::mutex mutex;
+
+#ifdef XR_USE_GRAPHICS_API_D3D12
+	std::optional<XrGraphicsRequirementsD3D12KHR> d3d12Requirements; // Includes adapter LUID
+	std::shared_ptr<wgpu::ChainedStruct> d3d12AdapterOptions;
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+	std::optional<XrGraphicsRequirementsVulkan2KHR> vulkanRequirements;
+	std::shared_ptr<wgpu::ChainedStruct> vulkanAdapterOptions; // Also owns its OpenXRConfig
+#endif
+
+	// Adapter options dropped by invalidate, kept alive until the instance is destroyed as the app may still use them.
+	std::vector<std::shared_ptr<wgpu::ChainedStruct>> retiredAdapterOptions;
+
+	explicit System(XrSystemId systemId) : systemId(systemId) {
+	}
+
+	// Drops cached state, call with mutex held.
+	void invalidate() {
+#ifdef XR_USE_GRAPHICS_API_D3D12
+		d3d12Requirements.reset();
+		if (d3d12AdapterOptions) retiredAdapterOptions.push_back(std::move(d3d12AdapterOptions));
+#endif
+#ifdef XR_USE_GRAPHICS_API_VULKAN
+		vulkanRequirements.reset();
+		if (vulkanAdapterOptions) retiredAdapterOptions.push_back(std::move(vulkanAdapterOptions));
+#endif
+	}
+};
+
+// Per XrInstance state. Entry points are resolved once when the instance is first used, instead of going through the
+// loader trampolines or xrGetInstanceProcAddr on every call. Extension entry points are null if not enabled.
+struct Instance {
+
+	XrInstance const instance;
+
+	XR_CORE_PROCS(XR_PROC)
+	XR_D3D12_PROCS(XR_PROC)
+	XR_VULKAN_PROCS(XR_PROC)
+
+	Instance(XrInstance instance, PFN_xrGetInstanceProcAddr getInstanceProcAddr);
+
+	// Returns cached state for a system, creating it on first use.
+	System* getSystem(XrSystemId systemId);
+
+	// Drops all cached system state, eg: after XR_ERROR_INSTANCE_LOST.
+	void invalidateSystems();
+
+	// Invalidates cached system state if r is XR_ERROR_INSTANCE_LOST, and returns r. Don't call with a system mutex held.
+	XrResult checkLost(XrResult r);
+
+private:
+	std::mutex systemsMutex;
+	std::unordered_map<XrSystemId, std::unique_ptr<System>> systems;
+};
+
+// Returns the dawnxr instance for an XrInstance, creating it on first use. Entry points are resolved with
+// getInstanceProcAddr, which the API layer sets to the next layer's so calls don't loop back through the loader.
+Instance* getInstance(XrInstance instance, PFN_xrGetInstanceProcAddr getInstanceProcAddr = xrGetInstanceProcAddr);
+
+// Destroys the dawnxr sessions and cached state of an instance, ahead of the instance itself being destroyed.
+void releaseInstance(XrInstance instance);
+
+// Per device completion serials, so the GPU work behind each swapchain release can be checked or waited on by itself
+// instead of idling the whole queue. Serials are signalled with Queue::OnSubmittedWorkDone, which completes in submit
+// order, so one completed serial covers every earlier one.
+class CompletionTracker {
+public:
+	explicit CompletionTracker(const wgpu::Device& device);
+
+	// Returns a serial that completes once all work submitted to the queue so far is done.
+	uint64_t signal();
+
+	// True if serial has completed, as of the device's last tick. Serial 0 is always complete.
+	bool isComplete(uint64_t serial) const;
+
+	// Ticks the device until serial completes or timeout nanoseconds have passed. Returns false on timeout.
+	bool wait(uint64_t serial, XrDuration timeout);
+
+private:
+	wgpu::Device const device;
+	std::atomic<uint64_t> nextSerial{};
+	std::shared_ptr<std::atomic<uint64_t>> const completedSerial; // Shared with pending callbacks
+};
+
+// Fullscreen triangle blits that sample one texture view into another with bilinear filtering, for mip generation and
+// the like. Pipelines are created on first use and cached per target format.
+class Blitter {
+public:
+	// A source view to blit from, with the rect of it that's sampled.
+	struct Source {
+		wgpu::BindGroup bindGroup;
+		wgpu::Buffer rectBuffer; // uv offset and scale of the rect
+		XrRect2Di rect{};		 // Last rect set, empty for the whole view
+	};
+
+	// A blit from a source view into a target view, created once and reused.
+	struct Pass {
+		Source source;
+		wgpu::TextureView target;
+		wgpu::TextureFormat format;
+	};
+
+	explicit Blitter(const wgpu::Device& device);
+
+	// Returns true if a format can be both sampled with filtering and rendered to.
+	static bool isBlittable(wgpu::TextureFormat format);
+
+	Source createSource(const wgpu::TextureView& source);
+
+	// Samples just rect of a width x height source from the next submit on, eg: a dynamic resolution rect. Writes the
+	// rect with the queue, so the source mustn't be in an encoded but unsubmitted blit.
+	void setSourceRect(Source& source, const XrRect2Di& rect, uint32_t width, uint32_t height);
+
+	Pass createPass(const wgpu::TextureView& source, const wgpu::TextureView& target, wgpu::TextureFormat format);
+
+	// Creates passes that downsample each mip from the one above it, for each array layer.
+	std::vector<Pass> createMipPasses(const wgpu::Texture& texture);
+
+	// Blits into the whole target, or into its top left targetExtent.
+	void encode(const wgpu::CommandEncoder& encoder, const Pass& pass, const XrExtent2Di* targetExtent = nullptr);
+
+	// As above, but into a target that changes every time, eg: a surface texture.
+	void encode(const wgpu::CommandEncoder& encoder, const Source& source, const wgpu::TextureView& target,
+				wgpu::TextureFormat format, const XrExtent2Di* targetExtent = nullptr);
+
+private:
+	wgpu::Device const device;
+	wgpu::ShaderModule shaderModule;
+	wgpu::Sampler sampler;
+	wgpu::BindGroupLayout bindGroupLayout;
+	wgpu::PipelineLayout pipelineLayout;
+
+	std::mutex pipelinesMutex;
+	std::unordered_map<wgpu::TextureFormat, wgpu::RenderPipeline> pipelines;
+
+	const wgpu::RenderPipeline& getPipeline(wgpu::TextureFormat format);
+};
+
 struct Session {
 
 	XrSession const backendSession;
 	wgpu::Device const device;
+	Instance* const dispatch; // nullptr for headless sessions
+
+	std::atomic<uint64_t> memoryUsage{}; // Estimated bytes held by swapchains, MSAA targets, uploads and readbacks
+	std::atomic<uint64_t> submitCount{}; // Queue submits made by dawnxr itself, see CommandBatch
+	CompletionTracker completion; // Serials of released swapchain images, see CompletionTracker
+
+	// Blitter for the session's device, created on first use.
+	Blitter& getBlitter();
 
 	virtual XrResult enumerateSwapchainFormats(std::vector<wgpu::TextureFormat>& formats) = 0;
 
 	virtual XrResult createSwapchain(const XrSwapchainCreateInfo* createInfo, std::vector<wgpu::Texture>& images,
 									 XrSwapchain* swapchain) = 0;
 
-	// TODO: destroySwapchainImages
+	// The remaining methods just forward to the runtime by default.
+
+	virtual XrResult destroySwapchain(XrSwapchain swapchain) {
+		return XR_RUNTIME(dispatch->xrDestroySwapchain(swapchain));
+	}
+
+	virtual XrResult acquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo,
+										   uint32_t* index) {
+		return XR_RUNTIME(dispatch->xrAcquireSwapchainImage(swapchain, acquireInfo, index));
+	}
+
+	virtual XrResult waitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo) {
+		return XR_RUNTIME(dispatch->xrWaitSwapchainImage(swapchain, waitInfo));
+	}
+
+	virtual XrResult releaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo) {
+		return XR_RUNTIME(dispatch->xrReleaseSwapchainImage(swapchain, releaseInfo));
+	}
+
+	virtual XrResult beginSession(const XrSessionBeginInfo* beginInfo) {
+		return XR_RUNTIME(dispatch->xrBeginSession(backendSession, beginInfo));
+	}
+
+	virtual XrResult endSession() {
+		return XR_RUNTIME(dispatch->xrEndSession(backendSession));
+	}
+
+	virtual XrResult waitFrame(const XrFrameWaitInfo* waitInfo, XrFrameState* frameState) {
+		return XR_RUNTIME(dispatch->xrWaitFrame(backendSession, waitInfo, frameState));
+	}
+
+	virtual XrResult beginFrame(const XrFrameBeginInfo* beginInfo) {
+		return XR_RUNTIME(dispatch->xrBeginFrame(backendSession, beginInfo));
+	}
+
+	virtual XrResult endFrame(const XrFrameEndInfo* endInfo) {
+		return XR_RUNTIME(dispatch->xrEndFrame(backendSession, endInfo));
+	}
+
+	virtual XrResult destroySession() {
+		return XR_RUNTIME(dispatch->xrDestroySession(backendSession));
+	}
+
+	// True if the runtime needs released images back in their attachment state, eg: RENDER_TARGET for D3D12 or
+	// COLOR_ATTACHMENT_OPTIMAL for Vulkan, after dawnxr has sampled or copied from them.
+	virtual bool needsAttachmentOnRelease() const {
+		return false;
+	}
 
 	virtual ~Session() = default;
 
+private:
+	std::once_flag blitterOnce;
+	std::unique_ptr<Blitter> blitter;
+
 protected:
-	Session(XrSession session, const wgpu::Device& device) : backendSession(session), device(device) {
+	Session(XrSession session, const wgpu::Device& device, Instance* dispatch)
+		: backendSession(session), device(device), dispatch(dispatch), completion(device) {
+	}
+};
+
+// Lazily created command encoder for dawnxr's own work, so each batch costs at most one queue submit.
+struct CommandBatch {
+	Session* const session;
+	wgpu::CommandEncoder encoder;
+
+	explicit CommandBatch(Session* session) : session(session) {
+	}
+
+	const wgpu::CommandEncoder& get();
+
+	// Submits the batch if anything was encoded. Returns true if it was.
+	bool submit();
+};
+
+// Brackets swapchain image usage between waitSwapchainImage and releaseSwapchainImage with GPU timestamp queries.
+struct GpuTimer {
+
+	static constexpr uint32_t slotCount = 4;
+
+	wgpu::Device const device;
+	const char* const name; // Timing event name
+	wgpu::QuerySet querySet;					// Begin/end timestamps for each slot
+	wgpu::Buffer resolveBuffer;					// Resolved timestamps for each slot
+	wgpu::Buffer readbackBuffers[slotCount];	// Mapped once the GPU is done with a slot
+
+	uint32_t slot = 0;
+	bool begun = false;
+	bool ended = false;
+	XrTime beginTime = 0;
+
+	// Begin of the next slot encoded by beginNext, waiting for submitted.
+	bool nextBegun = false;
+	XrTime nextBeginTime = 0;
+
+	// Completion serial of the submit holding a begin from beginNext, set by the caller. While it's incomplete the GPU
+	// is still busy with work submitted before the begin, so work submitted after it starts right where it was written.
+	uint64_t beginSerial = 0;
+
+	// Most recent GPU duration that hasn't been consumed yet, or 0. Shared with in flight readbacks.
+	std::shared_ptr<std::atomic<XrDuration>> const lastDuration = std::make_shared<std::atomic<XrDuration>>();
+
+	explicit GpuTimer(const wgpu::Device& device, const char* name = "swapchainImage (GPU)");
+
+	// Returns true if the device supports timestamp queries.
+	static bool isSupported(const wgpu::Device& device);
+
+	// Encodes the begin timestamp, unless the next slot is still being read back.
+	void begin(CommandBatch& batch);
+
+	// Encodes the end timestamp and its readback, if begun.
+	void end(CommandBatch& batch);
+
+	// Encodes the begin timestamp of the next slot after end, so the next begin can reuse it instead of submitting one
+	// of its own, see beginSerial. A later begin overwrites it.
+	void beginNext(CommandBatch& batch);
+
+	// Maps the readback once the commands from end have been submitted, and begins with any beginNext.
+	void submitted();
+};
+
+// Copies released swapchain images into a ring of MapRead buffers, optionally downscaling them first, and hands mapped
+// buffers to a callback. Images are dropped rather than stalling when every buffer is still in use.
+class Readback {
+public:
+	Readback(Session* session, const XrSwapchainCreateInfo& createInfo,
+			 const std::vector<SwapchainImageViewsDawn>& images, const ReadbackInfoDawn& info);
+
+	~Readback();
+
+	// Estimated bytes of the buffers and scaled texture, counted in the session's memoryUsage while alive.
+	uint64_t getMemoryUsage() const {
+		return memoryUsage;
 	}
+
+	// Encodes the copy of rect of an image, called by releaseSwapchainImage with the dynamic resolution rect. Returns
+	// false if it was dropped.
+	bool capture(CommandBatch& batch, uint32_t imageIndex, const XrRect2Di& rect);
+
+	// Maps the buffer of a capture once the batch has been submitted.
+	void submitted();
+
+	void getStats(ReadbackStatsDawn* stats) const;
+
+	struct State;
+
+private:
+	Session* const session;
+	wgpu::Device const device;
+	uint32_t const bufferCount;
+	uint32_t const arrayLayer;
+	uint32_t const downscale;
+	uint32_t const imageWidth;
+	uint32_t const imageHeight;
+	std::shared_ptr<State> const state; // Shared with in flight maps
+	uint64_t const memoryUsage;
+	wgpu::Texture scaledTexture;		// Downscale target, if downscaling
+	std::vector<wgpu::Texture> images;
+	std::vector<Blitter::Pass> scalePasses; // Per image, if downscaling
+	Blitter* blitter = nullptr;
+	uint32_t nextSlot = 0;
+	uint64_t sequence = 0;
+
+	// Capture waiting for submitted.
+	bool captured = false;
+	uint32_t capturedSlot = 0;
+	uint64_t capturedSequence = 0;
+	XrTime captureTime = 0;
+	uint32_t capturedWidth = 0;
+	uint32_t capturedHeight = 0;
 };
 
+// Copies whole images into released swapchain images from a ring of MapWrite staging buffers that producer threads write
+// into directly. Only the newest ended upload is copied on each release, older ones are handed straight back.
+class Upload {
+public:
+	Upload(Session* session, const XrSwapchainCreateInfo& createInfo,
+		   const std::vector<SwapchainImageViewsDawn>& images, const UploadInfoDawn& info);
+
+	~Upload();
+
+	// Estimated bytes of the staging buffers and latest texture, counted in the session's memoryUsage while alive.
+	uint64_t getMemoryUsage() const {
+		return memoryUsage;
+	}
+
+	// Gets a free buffer for a producer, from any thread.
+	XrResult begin(XrDuration timeout, UploadBufferDawn* buffer);
+
+	// Marks a producer's buffer ready for the next release, from any thread.
+	XrResult end(const UploadBufferDawn* buffer);
+
+	// Encodes the copy of the newest ready buffer into an image, or of the last upload if the image doesn't have it yet,
+	// called by releaseSwapchainImage. Returns true if a copy was encoded.
+	bool encode(CommandBatch& batch, uint32_t imageIndex);
+
+	// Maps the copied buffer again once the batch has been submitted.
+	void submitted();
+
+	void getStats(UploadStatsDawn* stats) const;
+
+	struct State;
+
+private:
+	Session* const session;
+	uint32_t const arrayLayer;
+	std::shared_ptr<State> const state; // Shared with in flight maps
+	uint64_t const memoryUsage;
+	std::vector<wgpu::Texture> images;
+
+	// Copy of the last upload for images released after it, as its buffer is mapped again once copied. Null for single
+	// image swapchains.
+	wgpu::Texture latest;
+	uint64_t latestSequence = 0;		  // Sequence + 1 of the last upload, 0 before the first
+	std::vector<uint64_t> imageSequences; // latestSequence each image was last brought up to
+
+	// Copy waiting for submitted.
+	bool copied = false;
+	uint32_t copiedSlot = 0;
+};
+
+// Blits a layer of released swapchain images into a wgpu::Surface, at most once per period.
+class Mirror {
+public:
+	// Mirroring never uses Fifo, as that would add the surface's vsync wait to XR frames.
+	static bool isNonBlocking(wgpu::PresentMode mode);
+
+	// True if the surface supports the requested present mode, or the other non blocking one.
+	static bool isSupported(const wgpu::Device& device, const MirrorInfoDawn& info);
+
+	Mirror(Session* session, const XrSwapchainCreateInfo& createInfo,
+		   const std::vector<SwapchainImageViewsDawn>& images, const MirrorInfoDawn& info);
+
+	~Mirror();
+
+	// Encodes a blit of rect of an image if the mirror period has elapsed, called by releaseSwapchainImage with the
+	// dynamic resolution rect. Returns true if it was encoded.
+	bool encode(CommandBatch& batch, uint32_t imageIndex, const XrRect2Di& rect);
+
+	// Presents the blit once the batch has been submitted.
+	void submitted();
+
+	void getStats(MirrorStatsDawn* stats) const;
+
+private:
+	wgpu::Device const device;
+	wgpu::Surface const surface;
+	wgpu::TextureFormat const format;
+	XrDuration const period;
+	uint32_t const imageWidth;
+	uint32_t const imageHeight;
+	Blitter& blitter;
+	std::vector<Blitter::Source> sources; // Per image
+	std::unique_ptr<GpuTimer> gpuTimer;
+	XrTime lastPresentTime = 0;
+	bool encoded = false;
+	XrDuration encodeTime = 0;
+
+	std::atomic<uint64_t> frameCount{};
+	std::atomic<uint64_t> failedCount{};
+	std::atomic<XrDuration> lastCpuTime{};
+	std::atomic<XrDuration> lastGpuTime{};
+	std::atomic<XrDuration> totalCpuTime{};
+};
+
+// Returns the dawnxr session for a session handle, or nullptr if it isn't one.
+Session* findSession(XrSession session);
+
+// Cancels createSwapchainAsync calls still queued for a session, and waits for one that's being created.
+void cancelAsyncSwapchains(XrSession session);
+
+// Bytes per texel of a swapchain format.
+uint32_t getTexelSize(wgpu::TextureFormat format);
+
+// Maps XrSwapchainUsageFlags to the minimal set of texture usages needed to honour them.
+wgpu::TextureUsage getSwapchainTextureUsage(XrSwapchainUsageFlags usageFlags);
+
+// Whether a device can create textures of a swapchain format, for formats that are behind an optional feature.
+bool isSwapchainFormatSupported(const wgpu::Device& device, wgpu::TextureFormat format);
+
+XrResult createHeadlessSession(const XrSessionCreateInfo* createInfo, Session** session);
+
 #ifdef XR_USE_GRAPHICS_API_D3D12
-XrResult getD3D12GraphicsRequirements(XrInstance instance, XrSystemId systemId, GraphicsRequirementsDawn* requirements);
-XrResult createD3D12RequestAdapterOptions(XrInstance instance, XrSystemId systemId, wgpu::ChainedStruct** opts);
-XrResult createD3D12Session(XrInstance instance, const XrSessionCreateInfo* createInfo, Session** session);
+XrResult getD3D12GraphicsRequirements(Instance* instance, XrSystemId systemId, GraphicsRequirementsDawn* requirements);
+XrResult createD3D12RequestAdapterOptions(Instance* instance, XrSystemId systemId, wgpu::ChainedStruct** opts);
+XrResult createD3D12Session(Instance* instance, const XrSessionCreateInfo* createInfo, Session** session);
 #endif
 
 #ifdef XR_USE_GRAPHICS_API_VULKAN
-XrResult getVulkanGraphicsRequirements(XrInstance instance, XrSystemId systemId, GraphicsRequirementsDawn* requirements);
-XrResult createVulkanRequestAdapterOptions(XrInstance instance, XrSystemId systemId, wgpu::ChainedStruct** opts);
-XrResult createVulkanSession(XrInstance instance, const XrSessionCreateInfo* createInfo, Session** session);
+XrResult getVulkanGraphicsRequirements(Instance* instance, XrSystemId systemId, GraphicsRequirementsDawn* requirements);
+XrResult createVulkanRequestAdapterOptions(Instance* instance, XrSystemId systemId, wgpu::ChainedStruct** opts);
+XrResult createVulkanSession(Instance* instance, const XrSessionCreateInfo* createInfo, Session** session);
 #endif
 
 } // namespace dawnxr::internal
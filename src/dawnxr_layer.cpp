@@ -0,0 +1,350 @@
+// OpenXR API layer entry points, so apps and middleware can use the plain xr* functions with dawn handles. Only built
+// with DAWNXR_API_LAYER defined, see layer/XR_APILAYER_dawnxr.json.in.
+
+#ifdef DAWNXR_API_LAYER
+
+#include "dawnxr_handlemap.h"
+#include "dawnxr_internal.h"
+
+#include <openxr/openxr_loader_negotiation.h>
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#ifdef _WIN32
+#define DAWNXR_LAYER_EXPORT __declspec(dllexport)
+#else
+#define DAWNXR_LAYER_EXPORT __attribute__((visibility("default")))
+#endif
+
+// Entry points the layer intercepts, everything else goes straight to the next layer.
+#define XR_LAYER_PROCS(X)                                                                                                      \
+	X(xrDestroyInstance)                                                                                                       \
+	X(xrCreateSession)                                                                                                         \
+	X(xrDestroySession)                                                                                                        \
+	X(xrBeginSession)                                                                                                          \
+	X(xrEndSession)                                                                                                            \
+	X(xrWaitFrame)                                                                                                             \
+	X(xrBeginFrame)                                                                                                            \
+	X(xrEndFrame)                                                                                                              \
+	X(xrEnumerateSwapchainFormats)                                                                                             \
+	X(xrCreateSwapchain)                                                                                                       \
+	X(xrDestroySwapchain)                                                                                                      \
+	X(xrEnumerateSwapchainImages)                                                                                              \
+	X(xrAcquireSwapchainImage)                                                                                                 \
+	X(xrWaitSwapchainImage)                                                                                                    \
+	X(xrReleaseSwapchainImage)
+
+using namespace dawnxr::internal;
+
+namespace {
+
+struct LayerInstance {
+	PFN_xrGetInstanceProcAddr const nextGetInstanceProcAddr;
+	PFN_xrDestroyInstance const nextDestroyInstance;
+	Instance* const dispatch;
+	bool const dawnBindings; // False if the app enabled XR_KHR_D3D11_enable, whose structure types dawnxr borrows
+};
+
+// Dispatch data stored per session and swapchain handle, so calls on runtime handles go straight to the next layer
+// without a trip through the dawnxr wrappers.
+struct LayerHandle {
+	Instance* const dispatch;
+	XrInstance const instance;
+	XrSession const session; // Owning session of a swapchain
+	bool const dawn;
+};
+
+HandleMap<XrInstance, LayerInstance> g_layerInstances;
+
+HandleMap<XrSession, LayerHandle> g_layerSessions;
+
+HandleMap<XrSwapchain, LayerHandle> g_layerSwapchains;
+
+// Handles may be reused after being destroyed behind our back, eg: by a direct dawnxr::destroySession call.
+template <class K> void insertHandle(HandleMap<K, LayerHandle>& handles, K handle, LayerHandle* layerHandle) {
+	delete handles.erase(handle);
+	handles.insert(handle, layerHandle);
+}
+
+template <class K, class F> void eraseHandles(HandleMap<K, LayerHandle>& handles, F pred) {
+	std::vector<K> erased;
+	handles.forEach([&](K handle, LayerHandle* layerHandle) {
+		if (pred(layerHandle)) erased.push_back(handle);
+	});
+	for (auto handle : erased) delete handles.erase(handle);
+}
+
+namespace intercept {
+
+// ***** Instance *****
+
+XrResult XRAPI_CALL xrDestroyInstance(XrInstance instance) {
+
+	std::unique_ptr<LayerInstance> layerInstance(g_layerInstances.erase(instance));
+	if (!layerInstance) return XR_ERROR_HANDLE_INVALID;
+
+	releaseInstance(instance);
+
+	eraseHandles(g_layerSwapchains, [instance](LayerHandle* handle) { return handle->instance == instance; });
+	eraseHandles(g_layerSessions, [instance](LayerHandle* handle) { return handle->instance == instance; });
+
+	return layerInstance->nextDestroyInstance(instance);
+}
+
+// ***** Session *****
+
+XrResult XRAPI_CALL xrCreateSession(XrInstance instance, const XrSessionCreateInfo* createInfo, XrSession* session) {
+
+	auto layerInstance = g_layerInstances.find(instance);
+	if (!layerInstance) return XR_ERROR_HANDLE_INVALID;
+
+	auto binding = (const XrBaseInStructure*)createInfo->next;
+	bool dawn = layerInstance->dawnBindings && binding && binding->type == XR_TYPE_GRAPHICS_BINDING_DAWN_EXT;
+
+	if (dawn) {
+		XR_TRY(dawnxr::createSession(instance, createInfo, session));
+	} else {
+		XR_TRY(layerInstance->dispatch->xrCreateSession(instance, createInfo, session));
+	}
+
+	insertHandle(g_layerSessions, *session, new LayerHandle{layerInstance->dispatch, instance, *session, dawn});
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrDestroySession(XrSession session) {
+
+	std::unique_ptr<LayerHandle> layerSession(g_layerSessions.erase(session));
+	if (!layerSession) return XR_ERROR_HANDLE_INVALID;
+
+	// Destroying a session destroys its swapchains.
+	eraseHandles(g_layerSwapchains, [session](LayerHandle* handle) { return handle->session == session; });
+
+	if (layerSession->dawn) return dawnxr::destroySession(session);
+
+	return layerSession->dispatch->xrDestroySession(session);
+}
+
+XrResult XRAPI_CALL xrBeginSession(XrSession session, const XrSessionBeginInfo* beginInfo) {
+
+	auto layerSession = g_layerSessions.find(session);
+	if (!layerSession) return XR_ERROR_HANDLE_INVALID;
+
+	if (layerSession->dawn) return dawnxr::beginSession(session, beginInfo);
+
+	return layerSession->dispatch->xrBeginSession(session, beginInfo);
+}
+
+XrResult XRAPI_CALL xrEndSession(XrSession session) {
+
+	auto layerSession = g_layerSessions.find(session);
+	if (!layerSession) return XR_ERROR_HANDLE_INVALID;
+
+	if (layerSession->dawn) return dawnxr::endSession(session);
+
+	return layerSession->dispatch->xrEndSession(session);
+}
+
+XrResult XRAPI_CALL xrWaitFrame(XrSession session, const XrFrameWaitInfo* waitInfo, XrFrameState* frameState) {
+
+	auto layerSession = g_layerSessions.find(session);
+	if (!layerSession) return XR_ERROR_HANDLE_INVALID;
+
+	if (layerSession->dawn) return dawnxr::waitFrame(session, waitInfo, frameState);
+
+	return layerSession->dispatch->xrWaitFrame(session, waitInfo, frameState);
+}
+
+XrResult XRAPI_CALL xrBeginFrame(XrSession session, const XrFrameBeginInfo* beginInfo) {
+
+	auto layerSession = g_layerSessions.find(session);
+	if (!layerSession) return XR_ERROR_HANDLE_INVALID;
+
+	if (layerSession->dawn) return dawnxr::beginFrame(session, beginInfo);
+
+	return layerSession->dispatch->xrBeginFrame(session, beginInfo);
+}
+
+XrResult XRAPI_CALL xrEndFrame(XrSession session, const XrFrameEndInfo* endInfo) {
+
+	auto layerSession = g_layerSessions.find(session);
+	if (!layerSession) return XR_ERROR_HANDLE_INVALID;
+
+	if (layerSession->dawn) return dawnxr::endFrame(session, endInfo);
+
+	return layerSession->dispatch->xrEndFrame(session, endInfo);
+}
+
+// ***** Swapchain *****
+
+XrResult XRAPI_CALL xrEnumerateSwapchainFormats(XrSession session, uint32_t formatCapacityInput,
+												uint32_t* formatCountOutput, int64_t* formats) {
+
+	auto layerSession = g_layerSessions.find(session);
+	if (!layerSession) return XR_ERROR_HANDLE_INVALID;
+
+	if (layerSession->dawn) {
+		return dawnxr::enumerateSwapchainFormats(session, formatCapacityInput, formatCountOutput, formats);
+	}
+
+	auto& next = layerSession->dispatch->xrEnumerateSwapchainFormats;
+	return next(session, formatCapacityInput, formatCountOutput, formats);
+}
+
+XrResult XRAPI_CALL xrCreateSwapchain(XrSession session, const XrSwapchainCreateInfo* createInfo,
+									  XrSwapchain* swapchain) {
+
+	auto layerSession = g_layerSessions.find(session);
+	if (!layerSession) return XR_ERROR_HANDLE_INVALID;
+
+	if (layerSession->dawn) {
+		XR_TRY(dawnxr::createSwapchain(session, createInfo, swapchain));
+	} else {
+		XR_TRY(layerSession->dispatch->xrCreateSwapchain(session, createInfo, swapchain));
+	}
+
+	insertHandle(g_layerSwapchains, *swapchain,
+				 new LayerHandle{layerSession->dispatch, layerSession->instance, session, layerSession->dawn});
+
+	return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL xrDestroySwapchain(XrSwapchain swapchain) {
+
+	std::unique_ptr<LayerHandle> layerSwapchain(g_layerSwapchains.erase(swapchain));
+	if (!layerSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (layerSwapchain->dawn) return dawnxr::destroySwapchain(swapchain);
+
+	return layerSwapchain->dispatch->xrDestroySwapchain(swapchain);
+}
+
+XrResult XRAPI_CALL xrEnumerateSwapchainImages(XrSwapchain swapchain, uint32_t imageCapacityInput,
+											   uint32_t* imageCountOutput, XrSwapchainImageBaseHeader* images) {
+
+	auto layerSwapchain = g_layerSwapchains.find(swapchain);
+	if (!layerSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (layerSwapchain->dawn) {
+		return dawnxr::enumerateSwapchainImages(swapchain, imageCapacityInput, imageCountOutput, images);
+	}
+
+	auto& next = layerSwapchain->dispatch->xrEnumerateSwapchainImages;
+	return next(swapchain, imageCapacityInput, imageCountOutput, images);
+}
+
+XrResult XRAPI_CALL xrAcquireSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageAcquireInfo* acquireInfo,
+											uint32_t* index) {
+
+	auto layerSwapchain = g_layerSwapchains.find(swapchain);
+	if (!layerSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (layerSwapchain->dawn) return dawnxr::acquireSwapchainImage(swapchain, acquireInfo, index);
+
+	return layerSwapchain->dispatch->xrAcquireSwapchainImage(swapchain, acquireInfo, index);
+}
+
+XrResult XRAPI_CALL xrWaitSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageWaitInfo* waitInfo) {
+
+	auto layerSwapchain = g_layerSwapchains.find(swapchain);
+	if (!layerSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (layerSwapchain->dawn) return dawnxr::waitSwapchainImage(swapchain, waitInfo);
+
+	return layerSwapchain->dispatch->xrWaitSwapchainImage(swapchain, waitInfo);
+}
+
+XrResult XRAPI_CALL xrReleaseSwapchainImage(XrSwapchain swapchain, const XrSwapchainImageReleaseInfo* releaseInfo) {
+
+	auto layerSwapchain = g_layerSwapchains.find(swapchain);
+	if (!layerSwapchain) return XR_ERROR_HANDLE_INVALID;
+
+	if (layerSwapchain->dawn) return dawnxr::releaseSwapchainImage(swapchain, releaseInfo);
+
+	return layerSwapchain->dispatch->xrReleaseSwapchainImage(swapchain, releaseInfo);
+}
+
+} // namespace intercept
+
+// ***** Loader interface *****
+
+XrResult XRAPI_CALL layerGetInstanceProcAddr(XrInstance instance, const char* name, PFN_xrVoidFunction* function) {
+
+	if (!strcmp(name, "xrGetInstanceProcAddr")) {
+		*function = (PFN_xrVoidFunction)layerGetInstanceProcAddr;
+		return XR_SUCCESS;
+	}
+
+#define XR_LAYER_PROC(FUNCID)                                                                                                  \
+	if (!strcmp(name, #FUNCID)) {                                                                                              \
+		*function = (PFN_xrVoidFunction)intercept::FUNCID;                                                                     \
+		return XR_SUCCESS;                                                                                                     \
+	}
+	XR_LAYER_PROCS(XR_LAYER_PROC)
+#undef XR_LAYER_PROC
+
+	auto layerInstance = g_layerInstances.find(instance);
+	if (!layerInstance) {
+		*function = nullptr;
+		return XR_ERROR_HANDLE_INVALID;
+	}
+
+	return layerInstance->nextGetInstanceProcAddr(instance, name, function);
+}
+
+XrResult XRAPI_CALL layerCreateApiLayerInstance(const XrInstanceCreateInfo* createInfo,
+												const XrApiLayerCreateInfo* layerCreateInfo, XrInstance* instance) {
+
+	if (!layerCreateInfo || layerCreateInfo->structType != XR_LOADER_INTERFACE_STRUCT_API_LAYER_CREATE_INFO ||
+		!layerCreateInfo->nextInfo) {
+		return XR_ERROR_INITIALIZATION_FAILED;
+	}
+	auto nextInfo = layerCreateInfo->nextInfo;
+
+	auto nextCreateInfo = *layerCreateInfo;
+	nextCreateInfo.nextInfo = nextInfo->next;
+	XR_TRY(nextInfo->nextCreateApiLayerInstance(createInfo, &nextCreateInfo, instance));
+
+	PFN_xrDestroyInstance nextDestroyInstance{};
+	nextInfo->nextGetInstanceProcAddr(*instance, "xrDestroyInstance", (PFN_xrVoidFunction*)&nextDestroyInstance);
+
+	bool dawnBindings = true;
+	for (auto i = 0u; i < createInfo->enabledExtensionCount; ++i) {
+		if (!strcmp(createInfo->enabledExtensionNames[i], XR_KHR_D3D11_ENABLE_EXTENSION_NAME)) dawnBindings = false;
+	}
+
+	// Register the instance before anything else can create it with entry points that loop back through the loader.
+	auto dispatch = getInstance(*instance, nextInfo->nextGetInstanceProcAddr);
+
+	g_layerInstances.insert(
+		*instance, new LayerInstance{nextInfo->nextGetInstanceProcAddr, nextDestroyInstance, dispatch, dawnBindings});
+
+	return XR_SUCCESS;
+}
+
+} // namespace
+
+extern "C" DAWNXR_LAYER_EXPORT XrResult XRAPI_CALL xrNegotiateLoaderApiLayerInterface(
+	const XrNegotiateLoaderInfo* loaderInfo, const char* layerName, XrNegotiateApiLayerRequest* apiLayerRequest) {
+
+	if (!loaderInfo || loaderInfo->structType != XR_LOADER_INTERFACE_STRUCT_LOADER_INFO ||
+		loaderInfo->minInterfaceVersion > XR_CURRENT_LOADER_API_LAYER_VERSION ||
+		loaderInfo->maxInterfaceVersion < XR_CURRENT_LOADER_API_LAYER_VERSION) {
+		return XR_ERROR_INITIALIZATION_FAILED;
+	}
+	if (!apiLayerRequest || apiLayerRequest->structType != XR_LOADER_INTERFACE_STRUCT_API_LAYER_REQUEST) {
+		return XR_ERROR_INITIALIZATION_FAILED;
+	}
+
+	apiLayerRequest->layerInterfaceVersion = XR_CURRENT_LOADER_API_LAYER_VERSION;
+	apiLayerRequest->layerApiVersion = XR_CURRENT_API_VERSION;
+	apiLayerRequest->getInstanceProcAddr = layerGetInstanceProcAddr;
+	apiLayerRequest->createApiLayerInstance = layerCreateApiLayerInstance;
+
+	return XR_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,132 @@
+#include "dawnxr_internal.h"
+
+#include <algorithm>
+
+using namespace dawnxr::internal;
+
+namespace {
+
+// Returns false if the surface supports neither Mailbox nor Immediate (eg: some Wayland and Android ones), as Fifo can
+// block present on desktop vsync and stall the XR frame.
+bool getPresentMode(const wgpu::Device& device, const wgpu::Surface& surface, wgpu::PresentMode presentMode,
+					wgpu::PresentMode* mode) {
+
+	wgpu::SurfaceCapabilities caps;
+	surface.GetCapabilities(device.GetAdapter(), &caps);
+
+	auto begin = caps.presentModes, end = caps.presentModes + caps.presentModeCount;
+	for (auto candidate : {presentMode, wgpu::PresentMode::Mailbox, wgpu::PresentMode::Immediate}) {
+		if (Mirror::isNonBlocking(candidate) && std::find(begin, end, candidate) != end) {
+			*mode = candidate;
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace
+
+namespace dawnxr::internal {
+
+bool Mirror::isNonBlocking(wgpu::PresentMode mode) {
+	return mode == wgpu::PresentMode::Mailbox || mode == wgpu::PresentMode::Immediate;
+}
+
+bool Mirror::isSupported(const wgpu::Device& device, const MirrorInfoDawn& info) {
+	wgpu::PresentMode mode;
+	return getPresentMode(device, info.surface, info.presentMode, &mode);
+}
+
+Mirror::Mirror(Session* session, const XrSwapchainCreateInfo& createInfo,
+			   const std::vector<SwapchainImageViewsDawn>& images, const MirrorInfoDawn& info)
+	: device(session->device), surface(info.surface), format(info.format), period(info.period),
+	  imageWidth(createInfo.width), imageHeight(createInfo.height), blitter(session->getBlitter()) {
+
+	wgpu::SurfaceConfiguration config{};
+	config.device = device;
+	config.format = format;
+	config.usage = wgpu::TextureUsage::RenderAttachment;
+	config.width = info.width;
+	config.height = info.height;
+	getPresentMode(device, surface, info.presentMode, &config.presentMode);
+
+	surface.Configure(&config);
+
+	for (auto& image : images) {
+		wgpu::TextureViewDescriptor viewDesc{};
+		viewDesc.dimension = wgpu::TextureViewDimension::e2D;
+		viewDesc.baseArrayLayer = info.arrayLayer;
+		viewDesc.arrayLayerCount = 1;
+		viewDesc.mipLevelCount = 1;
+		sources.push_back(blitter.createSource(image.texture.CreateView(&viewDesc)));
+	}
+
+	if (GpuTimer::isSupported(device)) gpuTimer = std::make_unique<GpuTimer>(device, "mirror (GPU)");
+}
+
+Mirror::~Mirror() {
+	surface.Unconfigure();
+}
+
+bool Mirror::encode(CommandBatch& batch, uint32_t imageIndex, const XrRect2Di& rect) {
+
+	auto beginTime = getTime();
+	if (lastPresentTime && beginTime - lastPresentTime < period) return false;
+	lastPresentTime = beginTime;
+
+	XR_TIMER("mirror");
+
+	wgpu::SurfaceTexture surfaceTexture;
+	surface.GetCurrentTexture(&surfaceTexture);
+	if (surfaceTexture.status != wgpu::SurfaceGetCurrentTextureStatus::Success) {
+		// Eg: the window is minimized or being resized, just try again next period.
+		++failedCount;
+		return false;
+	}
+
+	auto& encoder = batch.get();
+
+	if (gpuTimer) {
+		if (auto gpuTime = gpuTimer->lastDuration->exchange(0, std::memory_order_acq_rel)) lastGpuTime = gpuTime;
+		gpuTimer->begin(batch);
+	}
+
+	// Stretches the rect rendered this frame over the whole surface.
+	auto& source = sources[imageIndex];
+	blitter.setSourceRect(source, rect, imageWidth, imageHeight);
+	blitter.encode(encoder, source, surfaceTexture.texture.CreateView(), format);
+
+	if (gpuTimer) gpuTimer->end(batch);
+
+	encoded = true;
+	encodeTime = getTime() - beginTime;
+
+	return true;
+}
+
+void Mirror::submitted() {
+
+	if (!encoded) return;
+	encoded = false;
+
+	auto beginTime = getTime();
+
+	if (gpuTimer) gpuTimer->submitted();
+
+	surface.Present();
+
+	auto cpuTime = encodeTime + (getTime() - beginTime);
+	lastCpuTime = cpuTime;
+	totalCpuTime += cpuTime;
+	++frameCount;
+}
+
+void Mirror::getStats(MirrorStatsDawn* stats) const {
+	stats->frameCount = frameCount;
+	stats->failedCount = failedCount;
+	stats->lastCpuTime = lastCpuTime;
+	stats->lastGpuTime = lastGpuTime;
+	stats->totalCpuTime = totalCpuTime;
+}
+
+} // namespace dawnxr::internal
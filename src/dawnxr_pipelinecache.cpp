@@ -0,0 +1,209 @@
+#include "dawnxr_internal.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+using namespace dawnxr::internal;
+
+namespace {
+
+uint64_t hashBytes(const void* data, size_t size) {
+	uint64_t hash = 14695981039346656037ull;
+	for (auto p = (const uint8_t*)data, end = p + size; p != end; ++p) hash = (hash ^ *p) * 1099511628211ull;
+	return hash;
+}
+
+std::string toHex(uint64_t value) {
+	std::ostringstream out;
+	out << std::hex << std::setw(16) << std::setfill('0') << value;
+	return out.str();
+}
+
+} // namespace
+
+namespace dawnxr {
+
+// Each blob is a file named by the hash of its key, holding the key size, the key and the value. The key is checked on
+// load so hash collisions are just misses.
+struct PipelineCache {
+	std::filesystem::path const path;
+	std::string const isolationKey;
+	wgpu::DawnCacheDeviceDescriptor cacheDesc;
+
+	std::mutex mutex;
+	// Dawn asks for a blob's size then loads it, so the first call reads the file and the second takes it from here.
+	std::unordered_map<std::string, std::string> pendingLoads;
+
+	std::atomic<uint64_t> hitCount{};
+	std::atomic<uint64_t> missCount{};
+	std::atomic<uint64_t> storeCount{};
+	std::atomic<uint64_t> loadedBytes{};
+	std::atomic<uint64_t> storedBytes{};
+
+	PipelineCache(std::filesystem::path path, std::string isolationKey)
+		: path(std::move(path)), isolationKey(std::move(isolationKey)) {
+		cacheDesc.isolationKey = this->isolationKey.c_str();
+		cacheDesc.loadDataFunction = load;
+		cacheDesc.storeDataFunction = store;
+		cacheDesc.functionUserdata = this;
+	}
+
+	std::filesystem::path getBlobPath(const void* key, size_t keySize) const {
+		return path / (toHex(hashBytes(key, keySize)) + ".bin");
+	}
+
+	// Returns the value for a key, or false if it's not on disk or the file is for another key.
+	bool readBlob(const std::string& key, std::string& value) const {
+
+		std::ifstream in(getBlobPath(key.data(), key.size()), std::ios::binary);
+		if (!in) return false;
+
+		uint64_t keySize = 0;
+		in.read((char*)&keySize, sizeof(keySize));
+		if (!in || keySize != key.size()) return false;
+
+		std::string fileKey(keySize, '\0');
+		in.read(fileKey.data(), (std::streamsize)keySize);
+		if (!in || fileKey != key) return false;
+
+		value.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	static size_t load(const void* key, size_t keySize, void* value, size_t valueSize, void* userdata) {
+
+		auto cache = (PipelineCache*)userdata;
+		std::string keyString((const char*)key, keySize);
+
+		std::unique_lock<std::mutex> lock(cache->mutex);
+
+		auto it = cache->pendingLoads.find(keyString);
+		if (it == cache->pendingLoads.end()) {
+			// Don't hold up other threads' pipeline compiles while we hit the disk.
+			lock.unlock();
+			std::string blob;
+			if (!cache->readBlob(keyString, blob)) {
+				++cache->missCount;
+				return 0;
+			}
+			lock.lock();
+			it = cache->pendingLoads.insert_or_assign(std::move(keyString), std::move(blob)).first;
+		}
+
+		auto size = it->second.size();
+		if (!value) return size;
+
+		if (valueSize < size) return 0;
+		std::memcpy(value, it->second.data(), size);
+		cache->pendingLoads.erase(it);
+
+		++cache->hitCount;
+		cache->loadedBytes += size;
+
+		return size;
+	}
+
+	static void store(const void* key, size_t keySize, const void* value, size_t valueSize, void* userdata) {
+
+		auto cache = (PipelineCache*)userdata;
+
+		// Write to a temp file and rename it into place, so a crash or another process never sees a partial blob.
+		auto blobPath = cache->getBlobPath(key, keySize);
+		auto tempPath = blobPath;
+		tempPath += "." + toHex((uint64_t)getTimingThreadId() << 48 ^ (uint64_t)getTime()) + ".tmp";
+		{
+			std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+			if (!out) return;
+
+			uint64_t size = keySize;
+			out.write((const char*)&size, sizeof(size));
+			out.write((const char*)key, (std::streamsize)keySize);
+			out.write((const char*)value, (std::streamsize)valueSize);
+			if (!out) {
+				out.close();
+				std::error_code ec;
+				std::filesystem::remove(tempPath, ec);
+				return;
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(tempPath, blobPath, ec);
+		if (ec) {
+			std::filesystem::remove(tempPath, ec);
+			return;
+		}
+
+		++cache->storeCount;
+		cache->storedBytes += valueSize;
+	}
+};
+
+XrResult createPipelineCache(XrInstance instance, const wgpu::Adapter& adapter, const char* directory,
+							 PipelineCache** pipelineCache) {
+
+	XR_TIMER("createPipelineCache");
+
+	if (!adapter || !directory) return XR_ERROR_VALIDATION_FAILURE;
+
+	XrInstanceProperties instanceProps{XR_TYPE_INSTANCE_PROPERTIES};
+	auto dispatch = getInstance(instance);
+	XR_TRY(XR_RUNTIME(dispatch->xrGetInstanceProperties(instance, &instanceProps)));
+
+	wgpu::AdapterProperties adapterProps{};
+	adapter.GetProperties(&adapterProps);
+
+	// Adapter LUIDs and physical device handles change between boots, so key on what identifies the compiled code.
+	std::ostringstream key;
+	// Bump the leading version if the blob file layout changes.
+	key << "dawnxr1;" << (uint32_t)adapterProps.backendType << ';' << std::hex << adapterProps.vendorID << ';'
+		<< adapterProps.deviceID << ';' << (adapterProps.driverDescription ? adapterProps.driverDescription : "") << ';'
+		<< instanceProps.runtimeName << ';' << instanceProps.runtimeVersion;
+	auto isolationKey = key.str();
+
+	auto path = std::filesystem::path(directory) / toHex(hashBytes(isolationKey.data(), isolationKey.size()));
+
+	std::error_code ec;
+	std::filesystem::create_directories(path, ec);
+	if (ec) return XR_ERROR_FILE_ACCESS_ERROR;
+
+	*pipelineCache = new PipelineCache(std::move(path), std::move(isolationKey));
+
+	return XR_SUCCESS;
+}
+
+XrResult chainPipelineCache(PipelineCache* pipelineCache, wgpu::DeviceDescriptor* deviceDesc) {
+
+	pipelineCache->cacheDesc.nextInChain = deviceDesc->nextInChain;
+	deviceDesc->nextInChain = &pipelineCache->cacheDesc;
+
+	return XR_SUCCESS;
+}
+
+XrResult getPipelineCacheStats(PipelineCache* pipelineCache, PipelineCacheStatsDawn* stats) {
+
+	stats->hitCount = pipelineCache->hitCount;
+	stats->missCount = pipelineCache->missCount;
+	stats->storeCount = pipelineCache->storeCount;
+	stats->loadedBytes = pipelineCache->loadedBytes;
+	stats->storedBytes = pipelineCache->storedBytes;
+
+	return XR_SUCCESS;
+}
+
+XrResult destroyPipelineCache(PipelineCache* pipelineCache) {
+
+	XR_TIMER("destroyPipelineCache");
+
+	delete pipelineCache;
+
+	return XR_SUCCESS;
+}
+
+} // namespace dawnxr
@@ -0,0 +1,188 @@
+#include "dawnxr_internal.h"
+
+#include <algorithm>
+
+using namespace dawnxr::internal;
+
+namespace dawnxr::internal {
+
+struct Readback::State {
+
+	struct Slot {
+		wgpu::Buffer buffer;
+		std::atomic<bool> busy{}; // Set from capture until the callback returns
+	};
+
+	std::function<void(const ReadbackFrameDawn&)> const callback;
+	uint32_t const width;
+	uint32_t const height;
+	uint32_t const bytesPerRow;
+	wgpu::TextureFormat const format;
+	std::unique_ptr<Slot[]> const slots;
+
+	std::atomic<uint64_t> capturedCount{};
+	std::atomic<uint64_t> deliveredCount{};
+	std::atomic<uint64_t> droppedCount{};
+};
+
+} // namespace dawnxr::internal
+
+namespace {
+
+struct PendingReadback {
+	std::shared_ptr<Readback::State> state;
+	uint32_t slot;
+	uint64_t sequence;
+	XrTime captureTime;
+	uint32_t width;
+	uint32_t height;
+};
+
+std::shared_ptr<Readback::State> createState(const XrSwapchainCreateInfo& createInfo, const ReadbackInfoDawn& info) {
+
+	auto format = (wgpu::TextureFormat)createInfo.format;
+	auto width = std::max(createInfo.width / info.downscale, 1u);
+	auto height = std::max(createInfo.height / info.downscale, 1u);
+
+	// Buffer copies need rows aligned to 256 bytes.
+	auto bytesPerRow = (width * getTexelSize(format) + 255) & ~255u;
+
+	auto slots = std::make_unique<Readback::State::Slot[]>(info.bufferCount);
+
+	return std::shared_ptr<Readback::State>(
+		new Readback::State{info.callback, width, height, bytesPerRow, format, std::move(slots)});
+}
+
+} // namespace
+
+namespace dawnxr::internal {
+
+Readback::Readback(Session* session, const XrSwapchainCreateInfo& createInfo,
+				   const std::vector<SwapchainImageViewsDawn>& images, const ReadbackInfoDawn& info)
+	: session(session), device(session->device), bufferCount(info.bufferCount), arrayLayer(info.arrayLayer),
+	  downscale(info.downscale), imageWidth(createInfo.width), imageHeight(createInfo.height),
+	  state(createState(createInfo, info)),
+	  memoryUsage((uint64_t)state->bytesPerRow * state->height * bufferCount +
+				  (downscale > 1 ? (uint64_t)state->width * state->height * getTexelSize(state->format) : 0)) {
+
+	session->memoryUsage += memoryUsage;
+
+	wgpu::BufferDescriptor bufferDesc{};
+	bufferDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+	bufferDesc.size = (uint64_t)state->bytesPerRow * state->height;
+	for (auto i = 0u; i < bufferCount; ++i) state->slots[i].buffer = device.CreateBuffer(&bufferDesc);
+
+	for (auto& image : images) this->images.push_back(image.texture);
+
+	if (info.downscale > 1) {
+		wgpu::TextureDescriptor textureDesc{};
+		textureDesc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc;
+		textureDesc.size = {state->width, state->height, 1};
+		textureDesc.format = state->format;
+		scaledTexture = device.CreateTexture(&textureDesc);
+		auto target = scaledTexture.CreateView();
+
+		blitter = &session->getBlitter();
+		for (auto& image : images) {
+			wgpu::TextureViewDescriptor viewDesc{};
+			viewDesc.dimension = wgpu::TextureViewDimension::e2D;
+			viewDesc.baseArrayLayer = arrayLayer;
+			viewDesc.arrayLayerCount = 1;
+			viewDesc.mipLevelCount = 1;
+			scalePasses.push_back(blitter->createPass(image.texture.CreateView(&viewDesc), target, state->format));
+		}
+	}
+}
+
+Readback::~Readback() {
+
+	// In flight maps keep the buffers alive and complete with the callback after we're gone.
+	if (scaledTexture) scaledTexture.Destroy();
+	session->memoryUsage -= memoryUsage;
+}
+
+bool Readback::capture(CommandBatch& batch, uint32_t imageIndex, const XrRect2Di& rect) {
+
+	auto captureSequence = sequence++;
+
+	auto& slot = state->slots[nextSlot];
+	if (slot.busy.exchange(true, std::memory_order_acq_rel)) {
+		// Oldest buffer still hasn't been consumed, drop this one rather than stall.
+		++state->droppedCount;
+		return false;
+	}
+	captured = true;
+	capturedSlot = nextSlot;
+	capturedSequence = captureSequence;
+	captureTime = getTime();
+	nextSlot = (nextSlot + 1) % bufferCount;
+
+	// Only the rect rendered to this frame, downscaled into the top left of scaledTexture. The buffers fit the whole
+	// image, so this never grows past them.
+	capturedWidth = std::max((uint32_t)rect.extent.width / downscale, 1u);
+	capturedHeight = std::max((uint32_t)rect.extent.height / downscale, 1u);
+
+	auto& encoder = batch.get();
+
+	wgpu::ImageCopyTexture source{};
+	if (blitter) {
+		auto& pass = scalePasses[imageIndex];
+		blitter->setSourceRect(pass.source, rect, imageWidth, imageHeight);
+		XrExtent2Di extent{(int32_t)capturedWidth, (int32_t)capturedHeight};
+		blitter->encode(encoder, pass, &extent);
+		source.texture = scaledTexture;
+	} else {
+		source.texture = images[imageIndex];
+		source.origin = {(uint32_t)rect.offset.x, (uint32_t)rect.offset.y, arrayLayer};
+	}
+
+	wgpu::ImageCopyBuffer destination{};
+	destination.buffer = slot.buffer;
+	destination.layout.bytesPerRow = state->bytesPerRow;
+	destination.layout.rowsPerImage = state->height;
+
+	wgpu::Extent3D size{capturedWidth, capturedHeight, 1};
+	encoder.CopyTextureToBuffer(&source, &destination, &size);
+
+	return true;
+}
+
+void Readback::submitted() {
+
+	if (!captured) return;
+	captured = false;
+
+	++state->capturedCount;
+
+	auto& slot = state->slots[capturedSlot];
+	auto pending =
+		new PendingReadback{state, capturedSlot, capturedSequence, captureTime, capturedWidth, capturedHeight};
+
+	slot.buffer.MapAsync(
+		wgpu::MapMode::Read, 0, wgpu::kWholeMapSize,
+		[](WGPUBufferMapAsyncStatus status, void* userdata) {
+			auto pending = (PendingReadback*)userdata;
+			auto& state = *pending->state;
+			auto& slot = state.slots[pending->slot];
+			if (status == WGPUBufferMapAsyncStatus_Success) {
+				ReadbackFrameDawn frame{pending->sequence, pending->captureTime, pending->width, pending->height,
+										state.bytesPerRow, state.format, slot.buffer.GetConstMappedRange()};
+				state.callback(frame);
+				++state.deliveredCount;
+				slot.buffer.Unmap();
+			} else {
+				++state.droppedCount;
+			}
+			slot.busy.store(false, std::memory_order_release);
+			delete pending;
+		},
+		pending);
+}
+
+void Readback::getStats(ReadbackStatsDawn* stats) const {
+	stats->capturedCount = state->capturedCount;
+	stats->deliveredCount = state->deliveredCount;
+	stats->droppedCount = state->droppedCount;
+}
+
+} // namespace dawnxr::internal
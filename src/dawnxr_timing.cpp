@@ -0,0 +1,384 @@
+#include "dawnxr_internal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+using namespace dawnxr::internal;
+
+namespace {
+
+constexpr uint32_t frameRingSize = 128;
+
+constexpr uint32_t gpuThreadId = ~0u;
+
+// An event in a frame slot, a seqlock so recording never blocks. sequence is 2 * frameIndex + 1 while a recording
+// thread writes the fields and 2 * frameIndex + 2 once they're published. Recorders only claim events that are
+// published or from older frames, so a recorder that's late for a recycled slot can't tear an event written for the
+// new frame, and pollFrameTimings checks sequence is unchanged after copying the fields. Fields are relaxed atomics to
+// make the racy copy well defined.
+struct EventSlot {
+	std::atomic<uint64_t> sequence{};
+	std::atomic<const char*> name{};
+	std::atomic<uint32_t> threadId{};
+	std::atomic<XrTime> beginTime{};
+	std::atomic<XrTime> endTime{};
+};
+
+// A frame in the timing ring. sequence is 2 * frameIndex while the frame is being recorded and 2 * frameIndex + 1 once
+// endTimingFrame completes it, events for any other frame are too late. Recorders reserve event indices with fetch_add,
+// so eventCount can overshoot maxEvents, and late recorders for the slot's previous frame can take indices whose events
+// then stay stamped with their own frame and are skipped.
+struct FrameSlot {
+	std::atomic<uint64_t> sequence{};
+	std::atomic<uint32_t> eventCount{};
+	EventSlot events[dawnxr::FrameTimingDawn::maxEvents];
+};
+
+FrameSlot g_frameRing[frameRingSize];
+
+std::atomic<uint64_t> g_frameIndex;
+
+std::atomic<uint32_t> g_nextThreadId;
+
+// Consumer side, only touched by pollFrameTimings.
+std::mutex g_pollMutex;
+uint64_t g_pollFrameIndex;
+
+constexpr uint32_t callStatsSize = 256;
+
+// Per entry point totals, keyed by timer name. Names are compared by content as the same literal can have a different
+// address in each translation unit. Slots are claimed once and never freed, the table only ever holds ~50 names.
+struct CallStatsSlot {
+	std::atomic<const char*> name{};
+	std::atomic<uint64_t> callCount{};
+	std::atomic<XrDuration> totalTime{};
+	std::atomic<XrDuration> runtimeTime{};
+};
+
+CallStatsSlot g_callStats[callStatsSize];
+
+uint32_t hashName(const char* name) {
+	uint32_t hash = 2166136261u;
+	for (; *name; ++name) hash = (hash ^ (uint8_t)*name) * 16777619u;
+	return hash;
+}
+
+CallStatsSlot* findCallStats(const char* name) {
+
+	for (auto i = hashName(name) % callStatsSize, n = 0u; n < callStatsSize; i = (i + 1) % callStatsSize, ++n) {
+		auto& slot = g_callStats[i];
+		auto slotName = slot.name.load(std::memory_order_acquire);
+		if (!slotName && slot.name.compare_exchange_strong(slotName, name, std::memory_order_acq_rel)) return &slot;
+		if (!strcmp(slotName, name)) return &slot;
+	}
+	return nullptr;
+}
+
+struct PendingQuery {
+	const char* name;
+	wgpu::Buffer buffer;
+	XrTime beginTime;
+	uint64_t frameIndex;
+	std::shared_ptr<std::atomic<XrDuration>> lastDuration;
+};
+
+} // namespace
+
+namespace dawnxr::internal {
+
+std::atomic<bool> g_timingEnabled;
+
+thread_local ScopedTimer* g_currentTimer;
+
+XrTime getTime() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t getTimingThreadId() {
+	thread_local uint32_t threadId = g_nextThreadId++;
+	return threadId;
+}
+
+uint64_t getTimingFrameIndex() {
+	return g_frameIndex.load(std::memory_order_acquire);
+}
+
+void recordTimingEvent(const char* name, uint32_t threadId, XrTime beginTime, XrTime endTime, uint64_t frameIndex) {
+
+	auto currentIndex = getTimingFrameIndex();
+	if (frameIndex == ~0ull) frameIndex = currentIndex;
+
+	// Too late, frame has been recycled.
+	if (currentIndex - frameIndex >= frameRingSize) return;
+
+	auto& frame = g_frameRing[frameIndex % frameRingSize];
+
+	// The slot may have been recycled since we checked the frame index.
+	if (frame.sequence.load(std::memory_order_acquire) / 2 != frameIndex) return;
+
+	auto index = frame.eventCount.fetch_add(1, std::memory_order_relaxed);
+	if (index >= FrameTimingDawn::maxEvents) return;
+
+	// Claim the event, unless another recorder is mid-write or it already holds this or a later frame.
+	auto& event = frame.events[index];
+	auto sequence = event.sequence.load(std::memory_order_relaxed);
+	if ((sequence & 1) || sequence > frameIndex * 2 ||
+		!event.sequence.compare_exchange_strong(sequence, frameIndex * 2 + 1, std::memory_order_relaxed)) {
+		return;
+	}
+	std::atomic_thread_fence(std::memory_order_release);
+
+	event.name.store(name, std::memory_order_relaxed);
+	event.threadId.store(threadId, std::memory_order_relaxed);
+	event.beginTime.store(beginTime, std::memory_order_relaxed);
+	event.endTime.store(endTime, std::memory_order_relaxed);
+
+	event.sequence.store(frameIndex * 2 + 2, std::memory_order_release);
+}
+
+void endTimingFrame() {
+
+	auto frameIndex = getTimingFrameIndex();
+
+	g_frameRing[frameIndex % frameRingSize].sequence.store(frameIndex * 2 + 1, std::memory_order_release);
+
+	// Reset the count before publishing the new frame, so recorders that see the frame also see the reset.
+	auto& next = g_frameRing[(frameIndex + 1) % frameRingSize];
+	next.eventCount.store(0, std::memory_order_relaxed);
+	next.sequence.store((frameIndex + 1) * 2, std::memory_order_release);
+
+	g_frameIndex.store(frameIndex + 1, std::memory_order_release);
+}
+
+void recordCallStats(const char* name, XrDuration totalTime, XrDuration runtimeTime) {
+
+	auto slot = findCallStats(name);
+	if (!slot) return;
+
+	slot->callCount.fetch_add(1, std::memory_order_relaxed);
+	slot->totalTime.fetch_add(totalTime, std::memory_order_relaxed);
+	slot->runtimeTime.fetch_add(runtimeTime, std::memory_order_relaxed);
+}
+
+GpuTimer::GpuTimer(const wgpu::Device& device, const char* name)
+	: device(device), name(name) {
+
+	wgpu::QuerySetDescriptor querySetDesc{};
+	querySetDesc.type = wgpu::QueryType::Timestamp;
+	querySetDesc.count = slotCount * 2;
+	querySet = device.CreateQuerySet(&querySetDesc);
+
+	wgpu::BufferDescriptor resolveDesc{};
+	resolveDesc.usage = wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc;
+	resolveDesc.size = slotCount * 2 * sizeof(uint64_t);
+	resolveBuffer = device.CreateBuffer(&resolveDesc);
+
+	wgpu::BufferDescriptor readbackDesc{};
+	readbackDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+	readbackDesc.size = 2 * sizeof(uint64_t);
+	for (auto& buffer : readbackBuffers) buffer = device.CreateBuffer(&readbackDesc);
+}
+
+bool GpuTimer::isSupported(const wgpu::Device& device) {
+	return device.HasFeature(wgpu::FeatureName::TimestampQuery);
+}
+
+void GpuTimer::begin(CommandBatch& batch) {
+
+	// Skip this image if the slot's previous readback is still in flight.
+	if (readbackBuffers[slot].GetMapState() != wgpu::BufferMapState::Unmapped) return;
+
+	batch.get().WriteTimestamp(querySet, slot * 2);
+
+	beginTime = getTime();
+	begun = true;
+}
+
+void GpuTimer::end(CommandBatch& batch) {
+
+	if (!begun) return;
+	begun = false;
+
+	auto offset = slot * 2 * sizeof(uint64_t);
+
+	auto& encoder = batch.get();
+	encoder.WriteTimestamp(querySet, slot * 2 + 1);
+	encoder.ResolveQuerySet(querySet, slot * 2, 2, resolveBuffer, offset);
+	encoder.CopyBufferToBuffer(resolveBuffer, offset, readbackBuffers[slot], 0, 2 * sizeof(uint64_t));
+
+	ended = true;
+}
+
+void GpuTimer::beginNext(CommandBatch& batch) {
+
+	auto next = ended ? (slot + 1) % slotCount : slot;
+	if (begun || readbackBuffers[next].GetMapState() != wgpu::BufferMapState::Unmapped) return;
+
+	batch.get().WriteTimestamp(querySet, next * 2);
+
+	nextBeginTime = getTime();
+	nextBegun = true;
+}
+
+void GpuTimer::submitted() {
+
+	if (ended) {
+		ended = false;
+
+		// GPU timestamps aren't on the CPU clock, so line them up with the CPU time the timer began.
+		auto pending = new PendingQuery{name, readbackBuffers[slot], beginTime, getTimingFrameIndex(), lastDuration};
+
+		pending->buffer.MapAsync(
+			wgpu::MapMode::Read, 0, 2 * sizeof(uint64_t),
+			[](WGPUBufferMapAsyncStatus status, void* userdata) {
+				auto pending = (PendingQuery*)userdata;
+				if (status == WGPUBufferMapAsyncStatus_Success) {
+					auto timestamps = (const uint64_t*)pending->buffer.GetConstMappedRange(0, 2 * sizeof(uint64_t));
+					auto duration = (XrTime)(timestamps[1] - timestamps[0]);
+					pending->lastDuration->store(std::max(duration, (XrTime)1), std::memory_order_release);
+					if (g_timingEnabled.load(std::memory_order_relaxed)) {
+						recordTimingEvent(pending->name, gpuThreadId, pending->beginTime, pending->beginTime + duration,
+										  pending->frameIndex);
+					}
+					pending->buffer.Unmap();
+				}
+				delete pending;
+			},
+			pending);
+
+		slot = (slot + 1) % slotCount;
+	}
+
+	if (nextBegun) {
+		nextBegun = false;
+		beginTime = nextBeginTime;
+		begun = true;
+	}
+}
+
+} // namespace dawnxr::internal
+
+namespace dawnxr {
+
+XrResult setTimingEnabled(bool enabled) {
+
+	g_timingEnabled.store(enabled, std::memory_order_relaxed);
+
+	return XR_SUCCESS;
+}
+
+XrResult pollFrameTimings(uint32_t frameCapacityInput, uint32_t* frameCountOutput, FrameTimingDawn* frames) {
+
+	std::lock_guard<std::mutex> lock(g_pollMutex);
+
+	auto currentIndex = getTimingFrameIndex();
+
+	// Skip frames that have already been recycled.
+	if (currentIndex - g_pollFrameIndex > frameRingSize - 1) g_pollFrameIndex = currentIndex - (frameRingSize - 1);
+
+	auto available = (uint32_t)(currentIndex - g_pollFrameIndex);
+	if (!frames) {
+		*frameCountOutput = available;
+		return XR_SUCCESS;
+	}
+
+	uint32_t n = 0;
+	for (; g_pollFrameIndex < currentIndex && n < frameCapacityInput; ++g_pollFrameIndex) {
+		auto& slot = g_frameRing[g_pollFrameIndex % frameRingSize];
+		if (slot.sequence.load(std::memory_order_acquire) != g_pollFrameIndex * 2 + 1) continue;
+
+		auto& frame = frames[n++];
+		frame.frameIndex = g_pollFrameIndex;
+		frame.eventCount = 0;
+
+		// Events still being written, eg: late GPU timings, or rewritten during the copy are skipped.
+		auto published = g_pollFrameIndex * 2 + 2;
+		auto count = std::min(slot.eventCount.load(std::memory_order_relaxed), FrameTimingDawn::maxEvents);
+		for (auto i = 0u; i < count; ++i) {
+			auto& event = slot.events[i];
+			if (event.sequence.load(std::memory_order_acquire) != published) continue;
+
+			TimingEventDawn copy{event.name.load(std::memory_order_relaxed),
+								 event.threadId.load(std::memory_order_relaxed),
+								 event.beginTime.load(std::memory_order_relaxed),
+								 event.endTime.load(std::memory_order_relaxed)};
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (event.sequence.load(std::memory_order_relaxed) != published) continue;
+
+			frame.events[frame.eventCount++] = copy;
+		}
+	}
+	*frameCountOutput = n;
+
+	return XR_SUCCESS;
+}
+
+XrResult getCallStats(uint32_t statsCapacityInput, uint32_t* statsCountOutput, CallStatsDawn* stats) {
+
+	uint32_t n = 0;
+	for (auto& slot : g_callStats) {
+		auto name = slot.name.load(std::memory_order_acquire);
+		if (!name) continue;
+		if (stats && n < statsCapacityInput) {
+			stats[n] = {name, slot.callCount.load(std::memory_order_relaxed),
+						slot.totalTime.load(std::memory_order_relaxed), slot.runtimeTime.load(std::memory_order_relaxed)};
+		}
+		++n;
+	}
+	*statsCountOutput = stats ? std::min(n, statsCapacityInput) : n;
+
+	return XR_SUCCESS;
+}
+
+XrResult resetCallStats() {
+
+	for (auto& slot : g_callStats) {
+		slot.callCount.store(0, std::memory_order_relaxed);
+		slot.totalTime.store(0, std::memory_order_relaxed);
+		slot.runtimeTime.store(0, std::memory_order_relaxed);
+	}
+
+	return XR_SUCCESS;
+}
+
+XrResult writeChromeTrace(const char* path) {
+
+	std::ofstream out(path);
+	if (!out) return XR_ERROR_FILE_ACCESS_ERROR;
+
+	out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+
+	std::vector<FrameTimingDawn> frames(16);
+	bool first = true;
+	for (;;) {
+		uint32_t n;
+		XR_TRY(pollFrameTimings((uint32_t)frames.size(), &n, frames.data()));
+		if (!n) break;
+
+		for (auto i = 0u; i < n; ++i) {
+			auto& frame = frames[i];
+			for (auto j = 0u; j < frame.eventCount; ++j) {
+				auto& event = frame.events[j];
+				if (!first) out << ",\n";
+				first = false;
+				// Chrome trace times are in microseconds.
+				out << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":0,\"tid\":"
+					<< (event.threadId == gpuThreadId ? -1 : (int64_t)event.threadId) << ",\"ts\":" << event.beginTime / 1000.0
+					<< ",\"dur\":" << (event.endTime - event.beginTime) / 1000.0 << ",\"args\":{\"frame\":" << frame.frameIndex
+					<< "}}";
+			}
+		}
+	}
+
+	out << "\n]}\n";
+
+	return out ? XR_SUCCESS : XR_ERROR_FILE_ACCESS_ERROR;
+}
+
+} // namespace dawnxr
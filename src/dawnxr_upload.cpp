@@ -0,0 +1,272 @@
+#include "dawnxr_internal.h"
+
+#include <chrono>
+#include <condition_variable>
+
+using namespace dawnxr::internal;
+
+namespace dawnxr::internal {
+
+struct Upload::State {
+
+	// Slots cycle Free -> Writing (producer) -> Ready -> Copying (releaseSwapchainImage) -> Free (map callback). Ready
+	// slots superseded by a newer one go straight back to Free.
+	enum SlotState : uint32_t { Free, Writing, Ready, Copying };
+
+	struct Slot {
+		wgpu::Buffer buffer;
+		void* data = nullptr;  // Mapped range, valid while Free or Writing
+		uint64_t sequence = 0; // Order of endUpload, written before the slot is made Ready
+		std::atomic<uint32_t> state{Free};
+	};
+
+	uint32_t const bufferCount;
+	uint32_t const width;
+	uint32_t const height;
+	uint32_t const bytesPerRow;
+	std::unique_ptr<Slot[]> const slots;
+
+	// Producers waiting for a free slot.
+	std::mutex mutex;
+	std::condition_variable freed;
+
+	std::atomic<uint32_t> nextSlot{};
+	std::atomic<uint64_t> sequence{};
+
+	std::atomic<uint64_t> uploadedCount{};
+	std::atomic<uint64_t> skippedCount{};
+	std::atomic<uint64_t> stallCount{};
+
+	void free(Slot& slot) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			slot.state.store(Free, std::memory_order_release);
+		}
+		freed.notify_all();
+	}
+
+	bool anyFree() const {
+		for (auto i = 0u; i < bufferCount; ++i) {
+			if (slots[i].state.load(std::memory_order_acquire) == Free) return true;
+		}
+		return false;
+	}
+};
+
+} // namespace dawnxr::internal
+
+namespace {
+
+struct PendingUpload {
+	std::shared_ptr<Upload::State> state;
+	uint32_t slot;
+};
+
+std::shared_ptr<Upload::State> createState(const XrSwapchainCreateInfo& createInfo, const UploadInfoDawn& info) {
+
+	// Buffer copies need rows aligned to 256 bytes.
+	auto bytesPerRow = (createInfo.width * getTexelSize((wgpu::TextureFormat)createInfo.format) + 255) & ~255u;
+
+	auto slots = std::make_unique<Upload::State::Slot[]>(info.bufferCount);
+
+	return std::shared_ptr<Upload::State>(
+		new Upload::State{info.bufferCount, createInfo.width, createInfo.height, bytesPerRow, std::move(slots)});
+}
+
+// The staging buffers, plus the latest texture for swapchains with more than one image.
+uint64_t estimateMemory(const Upload::State& state, const XrSwapchainCreateInfo& createInfo, size_t imageCount) {
+
+	auto memory = (uint64_t)state.bytesPerRow * state.height * state.bufferCount;
+	if (imageCount > 1) {
+		memory += (uint64_t)createInfo.width * createInfo.height * getTexelSize((wgpu::TextureFormat)createInfo.format);
+	}
+
+	return memory;
+}
+
+} // namespace
+
+namespace dawnxr::internal {
+
+Upload::Upload(Session* session, const XrSwapchainCreateInfo& createInfo,
+			   const std::vector<SwapchainImageViewsDawn>& images, const UploadInfoDawn& info)
+	: session(session), arrayLayer(info.arrayLayer), state(createState(createInfo, info)),
+	  memoryUsage(estimateMemory(*state, createInfo, images.size())) {
+
+	session->memoryUsage += memoryUsage;
+
+	// Buffers start out mapped, so producers can write the first images before the first release.
+	wgpu::BufferDescriptor bufferDesc{};
+	bufferDesc.usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc;
+	bufferDesc.size = (uint64_t)state->bytesPerRow * state->height;
+	bufferDesc.mappedAtCreation = true;
+	for (auto i = 0u; i < state->bufferCount; ++i) {
+		auto& slot = state->slots[i];
+		slot.buffer = session->device.CreateBuffer(&bufferDesc);
+		slot.data = slot.buffer.GetMappedRange();
+	}
+
+	for (auto& image : images) this->images.push_back(image.texture);
+	imageSequences.resize(images.size());
+
+	if (images.size() > 1) {
+		wgpu::TextureDescriptor textureDesc{};
+		textureDesc.usage = wgpu::TextureUsage::CopyDst | wgpu::TextureUsage::CopySrc;
+		textureDesc.size = {createInfo.width, createInfo.height, 1};
+		textureDesc.format = (wgpu::TextureFormat)createInfo.format;
+		latest = session->device.CreateTexture(&textureDesc);
+	}
+}
+
+Upload::~Upload() {
+
+	// In flight maps keep their buffers alive a little longer, but they're as good as gone.
+	if (latest) latest.Destroy();
+	session->memoryUsage -= memoryUsage;
+}
+
+XrResult Upload::begin(XrDuration timeout, UploadBufferDawn* buffer) {
+
+	// The upload may be disabled or its swapchain destroyed while we wait, so hold on to the state, not this.
+	auto state = this->state;
+
+	auto deadline = getTime() + timeout;
+	bool stalled = false;
+
+	for (;;) {
+		auto first = state->nextSlot.load(std::memory_order_relaxed);
+		for (auto i = 0u; i < state->bufferCount; ++i) {
+			auto index = (first + i) % state->bufferCount;
+			auto& slot = state->slots[index];
+
+			uint32_t expected = State::Free;
+			if (!slot.state.compare_exchange_strong(expected, State::Writing, std::memory_order_acq_rel)) continue;
+
+			state->nextSlot.store((index + 1) % state->bufferCount, std::memory_order_relaxed);
+
+			*buffer = {slot.data, state->width, state->height, state->bytesPerRow, index};
+			return XR_SUCCESS;
+		}
+
+		if (!stalled) {
+			stalled = true;
+			++state->stallCount;
+		}
+
+		auto remaining = deadline - getTime();
+		if (remaining <= 0) return XR_TIMEOUT_EXPIRED;
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->freed.wait_for(lock, std::chrono::nanoseconds(remaining), [state] { return state->anyFree(); });
+	}
+}
+
+XrResult Upload::end(const UploadBufferDawn* buffer) {
+
+	if (buffer->slot >= state->bufferCount) return XR_ERROR_VALIDATION_FAILURE;
+
+	auto& slot = state->slots[buffer->slot];
+	if (slot.state.load(std::memory_order_acquire) != State::Writing) return XR_ERROR_CALL_ORDER_INVALID;
+
+	slot.sequence = state->sequence++;
+	slot.state.store(State::Ready, std::memory_order_release);
+
+	return XR_SUCCESS;
+}
+
+bool Upload::encode(CommandBatch& batch, uint32_t imageIndex) {
+
+	// Only releases move slots out of Ready, so nothing else can race us for them.
+	State::Slot* ready = nullptr;
+	for (auto i = 0u; i < state->bufferCount; ++i) {
+		auto& slot = state->slots[i];
+		if (slot.state.load(std::memory_order_acquire) != State::Ready) continue;
+		if (ready && ready->sequence > slot.sequence) {
+			++state->skippedCount;
+			state->free(slot);
+			continue;
+		}
+		if (ready) {
+			++state->skippedCount;
+			state->free(*ready);
+		}
+		ready = &slot;
+	}
+
+	wgpu::ImageCopyTexture destination{};
+	destination.texture = images[imageIndex];
+	destination.origin = {0, 0, arrayLayer};
+
+	wgpu::Extent3D size{state->width, state->height, 1};
+
+	if (!ready) {
+		// Bring an image released since the last upload up to date with it.
+		if (imageSequences[imageIndex] == latestSequence) return false;
+		imageSequences[imageIndex] = latestSequence;
+
+		wgpu::ImageCopyTexture source{};
+		source.texture = latest;
+		batch.get().CopyTextureToTexture(&source, &destination, &size);
+
+		return true;
+	}
+
+	ready->state.store(State::Copying, std::memory_order_relaxed);
+	ready->data = nullptr;
+	ready->buffer.Unmap();
+
+	wgpu::ImageCopyBuffer source{};
+	source.buffer = ready->buffer;
+	source.layout.bytesPerRow = state->bytesPerRow;
+	source.layout.rowsPerImage = state->height;
+
+	auto& encoder = batch.get();
+	encoder.CopyBufferToTexture(&source, &destination, &size);
+
+	latestSequence = ready->sequence + 1;
+	imageSequences[imageIndex] = latestSequence;
+	if (latest) {
+		wgpu::ImageCopyTexture latestDestination{};
+		latestDestination.texture = latest;
+		encoder.CopyBufferToTexture(&source, &latestDestination, &size);
+	}
+
+	copied = true;
+	copiedSlot = (uint32_t)(ready - state->slots.get());
+
+	return true;
+}
+
+void Upload::submitted() {
+
+	if (!copied) return;
+	copied = false;
+
+	++state->uploadedCount;
+
+	auto& slot = state->slots[copiedSlot];
+	auto pending = new PendingUpload{state, copiedSlot};
+
+	slot.buffer.MapAsync(
+		wgpu::MapMode::Write, 0, wgpu::kWholeMapSize,
+		[](WGPUBufferMapAsyncStatus status, void* userdata) {
+			auto pending = (PendingUpload*)userdata;
+			auto& state = *pending->state;
+			auto& slot = state.slots[pending->slot];
+			// A failed map means the device is gone, so the slot just stays out of the ring.
+			if (status == WGPUBufferMapAsyncStatus_Success) {
+				slot.data = slot.buffer.GetMappedRange();
+				state.free(slot);
+			}
+			delete pending;
+		},
+		pending);
+}
+
+void Upload::getStats(UploadStatsDawn* stats) const {
+	stats->uploadedCount = state->uploadedCount;
+	stats->skippedCount = state->skippedCount;
+	stats->stallCount = state->stallCount;
+}
+
+} // namespace dawnxr::internal
@@ -4,23 +4,76 @@
 
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 using namespace dawnxr::internal;
 
 namespace {
 
-const auto dawnSwapchainFormat = wgpu::TextureFormat::BGRA8UnormSrgb;
-const auto vulkanSwapchainFormat = VK_FORMAT_B8G8R8A8_SRGB;
+// Swapchain formats dawnxr can wrap. Enumeration order comes from the runtime, not this table.
+constexpr struct {
+	wgpu::TextureFormat dawnFormat;
+	VkFormat vulkanFormat;
+} swapchainFormats[] = {
+	{wgpu::TextureFormat::BGRA8UnormSrgb, VK_FORMAT_B8G8R8A8_SRGB},
+	{wgpu::TextureFormat::BGRA8Unorm, VK_FORMAT_B8G8R8A8_UNORM},
+	{wgpu::TextureFormat::RGBA8UnormSrgb, VK_FORMAT_R8G8B8A8_SRGB},
+	{wgpu::TextureFormat::RGBA8Unorm, VK_FORMAT_R8G8B8A8_UNORM},
+	{wgpu::TextureFormat::RGBA16Float, VK_FORMAT_R16G16B16A16_SFLOAT},
+	{wgpu::TextureFormat::RGB10A2Unorm, VK_FORMAT_A2B10G10R10_UNORM_PACK32},
+	{wgpu::TextureFormat::RG11B10Ufloat, VK_FORMAT_B10G11R11_UFLOAT_PACK32},
+	{wgpu::TextureFormat::RGBA32Float, VK_FORMAT_R32G32B32A32_SFLOAT},
+	{wgpu::TextureFormat::Depth16Unorm, VK_FORMAT_D16_UNORM},
+	{wgpu::TextureFormat::Depth32Float, VK_FORMAT_D32_SFLOAT},
+	// No Depth24PlusStencil8: dawn picks D24S8 or D32S8 for it depending on the device (eg: D32S8 on AMD), and doesn't
+	// tell us which, so a runtime's D24S8 images can't safely be wrapped as it.
+	{wgpu::TextureFormat::Depth32FloatStencil8, VK_FORMAT_D32_SFLOAT_S8_UINT},
+};
+
+VkFormat getVulkanFormat(wgpu::TextureFormat format) {
+	for (auto& it : swapchainFormats) {
+		if (it.dawnFormat == format) return it.vulkanFormat;
+	}
+	return VK_FORMAT_UNDEFINED;
+}
+
+wgpu::TextureFormat getDawnFormat(int64_t format) {
+	for (auto& it : swapchainFormats) {
+		if (it.vulkanFormat == (VkFormat)format) return it.dawnFormat;
+	}
+	return wgpu::TextureFormat::Undefined;
+}
+
+// Adapter options that own their OpenXRConfig.
+struct VulkanAdapterOptions : dawn::native::vulkan::RequestAdapterOptionsOpenXRConfig {
+	dawn::native::vulkan::OpenXRConfig xrConfig;
+};
 
 struct VulkanSession : Session {
 
-	VulkanSession(XrSession session, const wgpu::Device& device) : Session(session, device) {
+	VulkanSession(XrSession session, const wgpu::Device& device, Instance* dispatch) : Session(session, device, dispatch) {
+	}
+
+	bool needsAttachmentOnRelease() const override {
+		return true;
 	}
 
 	XrResult enumerateSwapchainFormats(std::vector<wgpu::TextureFormat>& formats) override {
 
-		formats.push_back(dawnSwapchainFormat);
+		uint32_t n;
+		XR_TRY(XR_RUNTIME(dispatch->xrEnumerateSwapchainFormats(backendSession, 0, &n, nullptr)));
+
+		std::vector<int64_t> vulkanFormats(n);
+		XR_TRY(XR_RUNTIME(dispatch->xrEnumerateSwapchainFormats(backendSession, n, &n, vulkanFormats.data())));
+
+		// Keep runtime preference order, skipping anything we can't wrap.
+		for (auto i = 0u; i < n; ++i) {
+			auto format = getDawnFormat(vulkanFormats[i]);
+			if (format != wgpu::TextureFormat::Undefined && isSwapchainFormatSupported(device, format)) {
+				formats.push_back(format);
+			}
+		}
 
 		return XR_SUCCESS;
 	}
@@ -30,31 +83,46 @@ struct VulkanSession : Session {
 
 		if (createInfo->type != XR_TYPE_SWAPCHAIN_CREATE_INFO) return XR_ERROR_HANDLE_INVALID;
 
-		if (createInfo->format != (int64_t)dawnSwapchainFormat) return XR_ERROR_RUNTIME_FAILURE;
+		auto format = (wgpu::TextureFormat)createInfo->format;
+		auto vulkanFormat = getVulkanFormat(format);
+		if (vulkanFormat == VK_FORMAT_UNDEFINED || !isSwapchainFormatSupported(device, format)) {
+			return XR_ERROR_SWAPCHAIN_FORMAT_UNSUPPORTED;
+		}
 
 		auto vulkanInfo = *createInfo;
-		vulkanInfo.format = vulkanSwapchainFormat;
+		vulkanInfo.format = vulkanFormat;
 
-		XR_TRY(xrCreateSwapchain(backendSession, &vulkanInfo, swapchain));
+		XR_TRY(XR_RUNTIME(dispatch->xrCreateSwapchain(backendSession, &vulkanInfo, swapchain)));
 
-		// TODO: Need to cleanup swapchain if any of the below fails
+		auto r = wrapSwapchainImages(createInfo, *swapchain, images);
+		if (XR_FAILED(r)) {
+			images.clear();
+			XR_RUNTIME(dispatch->xrDestroySwapchain(*swapchain));
+		}
+
+		return r;
+	}
+
+	XrResult wrapSwapchainImages(const XrSwapchainCreateInfo* createInfo, XrSwapchain swapchain,
+								 std::vector<wgpu::Texture>& images) {
 
 		uint32_t n;
 
-		XR_TRY(xrEnumerateSwapchainImages(*swapchain, 0, &n, nullptr));
+		XR_TRY(XR_RUNTIME(dispatch->xrEnumerateSwapchainImages(swapchain, 0, &n, nullptr)));
 		// XrSwapchainImageVulkan2KHR is an alias for XrSwapchainImageVulkanKHR
 		std::vector<XrSwapchainImageVulkan2KHR> vulkanImages(n,
 															 XrSwapchainImageVulkan2KHR{XR_TYPE_SWAPCHAIN_IMAGE_VULKAN2_KHR});
-		XR_TRY(xrEnumerateSwapchainImages(*swapchain, n, &n, (XrSwapchainImageBaseHeader*)vulkanImages.data()));
+		XR_TRY(XR_RUNTIME(
+			dispatch->xrEnumerateSwapchainImages(swapchain, n, &n, (XrSwapchainImageBaseHeader*)vulkanImages.data())));
 		if (n != vulkanImages.size()) return XR_ERROR_RUNTIME_FAILURE;
 
 		wgpu::TextureDescriptor textureDesc{
 			nullptr,												  // nextInChain
 			nullptr,												  // label
-			wgpu::TextureUsage::RenderAttachment |					  // usage
-				wgpu::TextureUsage::TextureBinding,					  // ...does this need to be optional?
+			getSwapchainTextureUsage(createInfo->usageFlags),		  // usage
 			wgpu::TextureDimension::e2D,							  // dimension
-			wgpu::Extent3D{createInfo->width, createInfo->height, 1}, // size
+			wgpu::Extent3D{createInfo->width, createInfo->height,	  // size
+						   createInfo->arraySize},					  // ...array layers
 			(wgpu::TextureFormat)createInfo->format,				  // format
 			createInfo->mipCount,									  // mipLevelCount;
 			createInfo->sampleCount,								  // sampleCount;
@@ -65,6 +133,7 @@ struct VulkanSession : Session {
 		for (auto& it : vulkanImages) {
 			auto texture = wgpu::Texture(
 				dawn::native::vulkan::CreateSwapchainWGPUTexture(device.Get(), (WGPUTextureDescriptor*)&textureDesc, it.image));
+			if (!texture) return XR_ERROR_RUNTIME_FAILURE;
 			images.push_back(texture);
 		}
 
@@ -76,12 +145,18 @@ struct VulkanSession : Session {
 
 namespace dawnxr::internal {
 
-XrResult getVulkanGraphicsRequirements(XrInstance instance, XrSystemId systemId, GraphicsRequirementsDawn* requirements) {
+XrResult getVulkanGraphicsRequirements(Instance* instance, XrSystemId systemId, GraphicsRequirementsDawn* requirements) {
 
-	XR_PROC(instance, xrGetVulkanGraphicsRequirements2KHR);
+	auto system = instance->getSystem(systemId);
+	std::lock_guard<std::mutex> lock(system->mutex);
+
+	if (system->vulkanRequirements) return XR_SUCCESS;
+
+	if (!instance->xrGetVulkanGraphicsRequirements2KHR) return XR_ERROR_FUNCTION_UNSUPPORTED;
 
 	XrGraphicsRequirementsVulkan2KHR vulkanReqs{XR_TYPE_GRAPHICS_REQUIREMENTS_VULKAN2_KHR};
-	XR_TRY(xrGetVulkanGraphicsRequirements2KHR(instance, systemId, &vulkanReqs));
+	XR_TRY(XR_RUNTIME(instance->xrGetVulkanGraphicsRequirements2KHR(instance->instance, systemId, &vulkanReqs)));
+	system->vulkanRequirements = vulkanReqs;
 
 	//	std::cout << "### Vulkan graphics requirements minApiVersionSupported: " << vulkanReqs.minApiVersionSupported
 	//			  << std::endl;
@@ -91,14 +166,26 @@ XrResult getVulkanGraphicsRequirements(XrInstance instance, XrSystemId systemId,
 	return XR_SUCCESS;
 }
 
-XrResult createVulkanRequestAdapterOptions(XrInstance instance, XrSystemId systemId, wgpu::ChainedStruct** opts) {
+XrResult createVulkanRequestAdapterOptions(Instance* instance, XrSystemId systemId, wgpu::ChainedStruct** opts) {
 
-	auto xrConfig = new dawn::native::vulkan::OpenXRConfig();
+	auto system = instance->getSystem(systemId);
+	std::lock_guard<std::mutex> lock(system->mutex);
+
+	if (system->vulkanAdapterOptions) {
+		*opts = system->vulkanAdapterOptions.get();
+		return XR_SUCCESS;
+	}
+
+	if (!instance->xrCreateVulkanInstanceKHR || !instance->xrGetVulkanGraphicsDevice2KHR ||
+		!instance->xrCreateVulkanDeviceKHR) {
+		return XR_ERROR_FUNCTION_UNSUPPORTED;
+	}
+
+	auto adapterOpts = std::make_shared<VulkanAdapterOptions>();
+	auto xrConfig = &adapterOpts->xrConfig;
 
 	xrConfig->CreateVkInstance = [=](PFN_vkGetInstanceProcAddr getProcAddr, const VkInstanceCreateInfo* vkCreateInfo,
 									 const VkAllocationCallbacks* vkAllocator, VkInstance* vkInstance) -> VkResult {
-		XR_PROC(instance, xrCreateVulkanInstanceKHR);
-
 		XrVulkanInstanceCreateInfoKHR createInfo{XR_TYPE_VULKAN_INSTANCE_CREATE_INFO_KHR};
 		createInfo.systemId = systemId;
 		createInfo.pfnGetInstanceProcAddr = getProcAddr;
@@ -106,19 +193,17 @@ XrResult createVulkanRequestAdapterOptions(XrInstance instance, XrSystemId syste
 		createInfo.vulkanAllocator = vkAllocator;
 
 		VkResult vkResult;
-		auto r = xrCreateVulkanInstanceKHR(instance, &createInfo, vkInstance, &vkResult);
+		auto r = XR_RUNTIME(instance->xrCreateVulkanInstanceKHR(instance->instance, &createInfo, vkInstance, &vkResult));
 		if (XR_FAILED(r)) return VK_ERROR_UNKNOWN;
 		return vkResult;
 	};
 
 	xrConfig->GetVkPhysicalDevice = [=](VkInstance vkInstance, VkPhysicalDevice* vkPDevice) -> VkResult {
-		XR_PROC(instance, xrGetVulkanGraphicsDevice2KHR);
-
 		XrVulkanGraphicsDeviceGetInfoKHR getInfo{XR_TYPE_VULKAN_GRAPHICS_DEVICE_GET_INFO_KHR};
 		getInfo.systemId = systemId;
 		getInfo.vulkanInstance = vkInstance;
 
-		auto r = xrGetVulkanGraphicsDevice2KHR(instance, &getInfo, vkPDevice);
+		auto r = XR_RUNTIME(instance->xrGetVulkanGraphicsDevice2KHR(instance->instance, &getInfo, vkPDevice));
 		if (XR_FAILED(r)) return VK_ERROR_UNKNOWN;
 		return VK_SUCCESS;
 	};
@@ -126,8 +211,6 @@ XrResult createVulkanRequestAdapterOptions(XrInstance instance, XrSystemId syste
 	xrConfig->CreateVkDevice = [=](PFN_vkGetInstanceProcAddr getProcAddr, VkPhysicalDevice vkPDevice,
 								   const VkDeviceCreateInfo* vkCreateInfo, const VkAllocationCallbacks* vkAllocator,
 								   VkDevice* vkDevice) -> VkResult {
-		XR_PROC(instance, xrCreateVulkanDeviceKHR);
-
 		XrVulkanDeviceCreateInfoKHR createInfo{XR_TYPE_VULKAN_DEVICE_CREATE_INFO_KHR};
 		createInfo.systemId = systemId;
 		createInfo.pfnGetInstanceProcAddr = getProcAddr;
@@ -136,19 +219,19 @@ XrResult createVulkanRequestAdapterOptions(XrInstance instance, XrSystemId syste
 		createInfo.vulkanAllocator = vkAllocator;
 
 		VkResult vkResult;
-		auto r = xrCreateVulkanDeviceKHR(instance, &createInfo, vkDevice, &vkResult);
+		auto r = XR_RUNTIME(instance->xrCreateVulkanDeviceKHR(instance->instance, &createInfo, vkDevice, &vkResult));
 		if (XR_FAILED(r)) return VK_ERROR_UNKNOWN;
 		return vkResult;
 	};
 
-	auto adapterOpts = new dawn::native::vulkan::RequestAdapterOptionsOpenXRConfig();
 	adapterOpts->openXRConfig = xrConfig;
-	*opts = adapterOpts;
+	system->vulkanAdapterOptions = adapterOpts;
+	*opts = adapterOpts.get();
 
 	return XR_SUCCESS;
 }
 
-XrResult createVulkanSession(XrInstance instance, const XrSessionCreateInfo* createInfo, Session** session) {
+XrResult createVulkanSession(Instance* instance, const XrSessionCreateInfo* createInfo, Session** session) {
 
 	if (createInfo->type != XR_TYPE_SESSION_CREATE_INFO) return XR_ERROR_HANDLE_INVALID;
 
@@ -170,8 +253,8 @@ XrResult createVulkanSession(XrInstance instance, const XrSessionCreateInfo* cre
 	vulkanCreateInfo.systemId = createInfo->systemId;
 
 	XrSession backendSession;
-	XR_TRY(xrCreateSession(instance, &vulkanCreateInfo, &backendSession));
-	*session = new VulkanSession(backendSession, dawnDevice);
+	XR_TRY(XR_RUNTIME(instance->xrCreateSession(instance->instance, &vulkanCreateInfo, &backendSession)));
+	*session = new VulkanSession(backendSession, dawnDevice, instance);
 
 	return XR_SUCCESS;
 }